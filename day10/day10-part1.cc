@@ -9,12 +9,15 @@
  */
 
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
 #include <fstream>
-#include <functional>
 #include <iostream>
 #include <memory>
-#include <queue>
-#include <set>
+#include <numeric>
+#include <span>
 #include <string>
 #include <utility>
 #include <vector>
@@ -22,23 +25,180 @@
 constexpr int kMaxHeight = 9;
 constexpr int kMinHeight = 0;
 
-using Position = std::pair<int, int>;
+// Set of peaks reachable from a cell, as indices local to the current tile
+// of peaks. Most cells reach only a handful of peaks and keep them as a
+// short sorted array inside the set; once a set outgrows kSmallLimit it
+// switches to a bitset spanning the whole tile.
+class PeakSet
+{
+public:
+    // Empties the set but keeps its buffers for the next use.
+    void Clear()
+    {
+        small_size_ = 0;
+        words_.clear();
+    }
+
+    void Insert(uint16_t peak)
+    {
+        small_[small_size_++] = peak;
+    }
+
+    void UnionWith(const PeakSet &other, size_t tile_words)
+    {
+        if (other.IsDense())
+        {
+            MakeDense(tile_words);
+            for (size_t word = 0; word < tile_words; ++word)
+            {
+                words_[word] |= other.words_[word];
+            }
+        }
+        else if (IsDense())
+        {
+            for (uint16_t peak : other.Small())
+            {
+                words_[peak / 64] |= uint64_t{1} << (peak % 64);
+            }
+        }
+        else if (small_size_ + other.small_size_ > kSmallLimit)
+        {
+            MakeDense(tile_words);
+            UnionWith(other, tile_words);
+        }
+        else
+        {
+            // Both sides are sorted and short, so merge them from the back
+            // in place.
+            size_t mine = small_size_;
+            size_t theirs = other.small_size_;
+            size_t out = mine + theirs;
+            while (theirs > 0)
+            {
+                small_[--out] = mine > 0 && small_[mine - 1] > other.small_[theirs - 1] ? small_[--mine] : other.small_[--theirs];
+            }
+            const auto merged = std::span(small_).first(small_size_ + other.small_size_);
+            small_size_ = static_cast<uint8_t>(std::unique(merged.begin(), merged.end()) - merged.begin());
+        }
+    }
+
+    [[nodiscard]] size_t Size() const
+    {
+        if (!IsDense())
+        {
+            return small_size_;
+        }
+        return std::accumulate(words_.begin(), words_.end(), size_t{0},
+                               [](size_t count, uint64_t word)
+                               { return count + std::popcount(word); });
+    }
+
+private:
+    static constexpr size_t kSmallLimit = 8;
+
+    [[nodiscard]] bool IsDense() const
+    {
+        return !words_.empty();
+    }
+
+    void MakeDense(size_t tile_words)
+    {
+        if (IsDense())
+        {
+            return;
+        }
+        words_.assign(tile_words, 0);
+        for (uint16_t peak : Small())
+        {
+            words_[peak / 64] |= uint64_t{1} << (peak % 64);
+        }
+        small_size_ = 0;
+    }
+
+    [[nodiscard]] std::span<const uint16_t> Small() const
+    {
+        return std::span(small_).first(small_size_);
+    }
+
+    std::array<uint16_t, kSmallLimit> small_{};
+    uint8_t small_size_ = 0;
+    std::vector<uint64_t> words_;
+};
 
 class TopographicMap
 {
 public:
     explicit TopographicMap(const std::string &filename) { LoadMap(filename); }
 
-    int CalculateTotalTrailheadScores();
+    uint64_t CalculateTotalTrailheadScores();
 
 private:
+    static constexpr uint8_t kPadding = 0xFF;
+
+    // Peaks are swept in tiles so that a dense set never needs more than
+    // kLargeTile bits, whatever the number of peaks on the map.
+    static constexpr size_t kSmallTile = 64;
+    static constexpr size_t kLargeTile = 512;
+
+    // Neighbour steps in the same order as neighbour_offsets_.
+    static constexpr std::array<int, 4> kDeltaRow{-1, 1, 0, 0};
+    static constexpr std::array<int, 4> kDeltaCol{0, 0, -1, 1};
+
+    // Cells a tile's sweep visits, in padded map coordinates, half-open.
+    struct TileBox
+    {
+        int row_begin = 0;
+        int row_end = 0;
+        int col_begin = 0;
+        int col_end = 0;
+
+        [[nodiscard]] bool Contains(int row, int col) const
+        {
+            return row >= row_begin && row < row_end && col >= col_begin && col < col_end;
+        }
+
+        [[nodiscard]] size_t Index(int row, int col) const
+        {
+            return static_cast<size_t>(row - row_begin) * (col_end - col_begin) + (col - col_begin);
+        }
+    };
+
     void LoadMap(const std::string &filename);
 
-    int CalculateTrailheadScore(const Position &start_pos);
+    void NumberPeaks(size_t tile);
+
+    uint64_t SweepPeakTile(size_t first_peak, size_t tile_size);
 
-    std::vector<std::vector<int>> map_data_;
+    template <typename Visit>
+    void ForEachCellInBox(int height, const TileBox &box, Visit &&visit) const;
+
+    [[nodiscard]] std::pair<uint32_t, uint32_t> Bucket(int height) const
+    {
+        return {bucket_start_[height], bucket_start_[height + 1]};
+    }
+
+    // Row-major heights with a border of kPadding cells.
+    std::vector<uint8_t> map_data_;
     int rows_ = 0;
     int cols_ = 0;
+    int stride_ = 0;
+    std::array<int, 4> neighbour_offsets_{};
+
+    // Cells of height h are by_height_[bucket_start_[h] .. bucket_start_[h + 1]),
+    // in row-major order.
+    std::array<uint32_t, kMaxHeight + 2> bucket_start_{};
+    std::vector<uint32_t> by_height_;
+
+    // Peak number n is the cell by_height_[bucket_start_[kMaxHeight] +
+    // peak_order_[n]], and peak_number_ is the inverse, indexed by a peak's
+    // position within its bucket.
+    std::vector<uint32_t> peak_order_;
+    std::vector<uint32_t> peak_number_;
+
+    // Reachable peaks of the level being computed and the level above it,
+    // indexed by position within the current tile's box.
+    std::vector<PeakSet> current_level_;
+    std::vector<PeakSet> upper_level_;
 };
 
 void TopographicMap::LoadMap(const std::string &filename)
@@ -50,95 +210,206 @@ void TopographicMap::LoadMap(const std::string &filename)
         return;
     }
 
+    std::vector<std::string> lines;
     std::string line;
     while (std::getline(input_file, line))
     {
-        std::vector<int> row;
-        for (char ch : line)
+        if (line.find_first_of("0123456789") != std::string::npos)
+        {
+            cols_ = std::max(cols_, static_cast<int>(line.size()));
+            lines.emplace_back(std::move(line));
+        }
+    }
+    rows_ = static_cast<int>(lines.size());
+
+    stride_ = cols_ + 2;
+    neighbour_offsets_ = {-stride_, stride_, -1, 1};
+    map_data_.assign(static_cast<size_t>(rows_ + 2) * stride_, kPadding);
+    for (int x = 0; x < rows_; ++x)
+    {
+        for (int y = 0; y < static_cast<int>(lines[x].size()); ++y)
         {
+            const char ch = lines[x][y];
             if (ch >= '0' && ch <= '9')
             {
-                row.push_back(ch - '0');
+                map_data_[static_cast<size_t>(x + 1) * stride_ + y + 1] = static_cast<uint8_t>(ch - '0');
             }
         }
-        if (!row.empty())
+    }
+
+    // Counting sort of the cells by height.
+    bucket_start_.fill(0);
+    for (uint8_t height : map_data_)
+    {
+        if (height <= kMaxHeight)
         {
-            map_data_.emplace_back(std::move(row));
+            ++bucket_start_[height + 1];
         }
     }
+    for (int h = kMinHeight; h <= kMaxHeight; ++h)
+    {
+        bucket_start_[h + 1] += bucket_start_[h];
+    }
 
-    rows_ = static_cast<int>(map_data_.size());
-    cols_ = rows_ > 0 ? static_cast<int>(map_data_[0].size()) : 0;
+    by_height_.resize(bucket_start_[kMaxHeight + 1]);
+    std::array<uint32_t, kMaxHeight + 1> next{};
+    std::copy_n(bucket_start_.begin(), next.size(), next.begin());
+    for (uint32_t cell = 0; cell < map_data_.size(); ++cell)
+    {
+        const uint8_t height = map_data_[cell];
+        if (height <= kMaxHeight)
+        {
+            by_height_[next[height]++] = cell;
+        }
+    }
 }
 
-int TopographicMap::CalculateTrailheadScore(const Position &start_pos)
+// Numbers the peaks row-major within vertical strips about as wide as a
+// tile of peaks is tall, so consecutive numbers form compact patches of the
+// map rather than slivers of very long rows. Every other strip runs bottom
+// to top, so a tile that spans two strips stays compact as well. A map
+// narrower than one strip is numbered plainly row-major.
+void TopographicMap::NumberPeaks(size_t tile)
 {
-    std::set<Position> visited;
-    std::set<Position> reached_nines;
+    auto [peak_begin, peak_end] = Bucket(kMaxHeight);
+    const size_t peak_count = peak_end - peak_begin;
+    const double cells_per_tile = static_cast<double>(rows_) * cols_ * static_cast<double>(tile) / static_cast<double>(peak_count);
+    const int strip_width = std::clamp(static_cast<int>(std::ceil(std::sqrt(cells_per_tile))), 1, cols_);
 
-    const auto IsValidPosition = [this](int x, int y)
+    peak_order_.resize(peak_count);
+    std::iota(peak_order_.begin(), peak_order_.end(), 0u);
+    auto strip_order = [&](uint32_t rank)
     {
-        return x >= 0 && x < rows_ && y >= 0 && y < cols_;
+        const uint32_t cell = by_height_[peak_begin + rank];
+        const int strip = static_cast<int>(cell % stride_ - 1) / strip_width;
+        const int row = static_cast<int>(cell / stride_);
+        return std::pair(strip, strip % 2 == 0 ? row : -row);
     };
+    std::ranges::stable_sort(peak_order_, {}, strip_order);
 
-    int score = 0;
-    std::queue<Position> queue;
-    queue.push(start_pos);
-    visited.insert(start_pos);
-
-    while (!queue.empty())
+    peak_number_.resize(peak_count);
+    for (uint32_t n = 0; n < peak_count; ++n)
     {
-        auto [x, y] = queue.front();
-        queue.pop();
-        int current_height = map_data_[x][y];
+        peak_number_[peak_order_[n]] = n;
+    }
+}
 
-        if (current_height == kMaxHeight)
+// Calls visit(k, cell, row, col) for every cell of the given height inside
+// the box. A bucket is sorted by cell, so each row of the box is one
+// contiguous range of it.
+template <typename Visit>
+void TopographicMap::ForEachCellInBox(int height, const TileBox &box, Visit &&visit) const
+{
+    auto [begin, end] = Bucket(height);
+    const auto first = by_height_.begin() + begin;
+    const auto last = by_height_.begin() + end;
+    for (int row = box.row_begin; row < box.row_end; ++row)
+    {
+        const uint32_t row_start = static_cast<uint32_t>(row * stride_);
+        auto it = std::lower_bound(first, last, row_start + box.col_begin);
+        for (; it != last && *it < row_start + box.col_end; ++it)
         {
-            reached_nines.insert({x, y});
-            continue;
+            const uint32_t cell = *it;
+            visit(static_cast<uint32_t>(it - by_height_.begin()), cell, row, static_cast<int>(cell - row_start));
         }
+    }
+}
+
+// Reverse DP for the peaks first_peak .. first_peak + tile_size - 1: every
+// peak starts with itself, and each lower level takes the union of its
+// uphill neighbours' sets. A trail is at most nine steps long, so only the
+// tile's bounding box grown by nine cells can reach its peaks, and since a
+// tile is a compact patch all tiles together stay proportional to the map.
+// Cells just outside the box are treated as reaching none of the tile's
+// peaks, which is exact for them. Returns the trailheads' scores
+// restricted to this tile.
+uint64_t TopographicMap::SweepPeakTile(size_t first_peak, size_t tile_size)
+{
+    const size_t tile_words = (tile_size + 63) / 64;
+    const uint32_t peak_begin = bucket_start_[kMaxHeight];
+
+    int row_min = rows_ + 1;
+    int row_max = 0;
+    int col_min = stride_;
+    int col_max = 0;
+    for (size_t n = first_peak; n < first_peak + tile_size; ++n)
+    {
+        const uint32_t cell = by_height_[peak_begin + peak_order_[n]];
+        const int row = static_cast<int>(cell / stride_);
+        const int col = static_cast<int>(cell % stride_);
+        row_min = std::min(row_min, row);
+        row_max = std::max(row_max, row);
+        col_min = std::min(col_min, col);
+        col_max = std::max(col_max, col);
+    }
+    const TileBox box{
+        std::max(1, row_min - kMaxHeight),
+        std::min(rows_ + 1, row_max + kMaxHeight + 1),
+        std::max(1, col_min - kMaxHeight),
+        std::min(cols_ + 1, col_max + kMaxHeight + 1)};
+
+    const size_t box_cells = static_cast<size_t>(box.row_end - box.row_begin) * (box.col_end - box.col_begin);
+    if (upper_level_.size() < box_cells)
+    {
+        upper_level_.resize(box_cells);
+        current_level_.resize(box_cells);
+    }
 
-        const std::vector<Position> directions = {
-            {x - 1, y}, {x + 1, y}, {x, y - 1}, {x, y + 1}};
+    // Peaks of other tiles inside the box start out empty.
+    auto seed_peak = [&](uint32_t k, uint32_t, int row, int col)
+    {
+        PeakSet &peaks = upper_level_[box.Index(row, col)];
+        peaks.Clear();
+        const size_t number = peak_number_[k - peak_begin];
+        if (number >= first_peak && number < first_peak + tile_size)
+        {
+            peaks.Insert(static_cast<uint16_t>(number - first_peak));
+        }
+    };
+    ForEachCellInBox(kMaxHeight, box, seed_peak);
 
-        for (const auto &[nx, ny] : directions)
+    for (int h = kMaxHeight - 1; h >= kMinHeight; --h)
+    {
+        auto merge_uphill = [&](uint32_t, uint32_t cell, int row, int col)
         {
-            if (IsValidPosition(nx, ny) && visited.find({nx, ny}) == visited.end())
+            PeakSet &peaks = current_level_[box.Index(row, col)];
+            peaks.Clear();
+            for (size_t dir = 0; dir < neighbour_offsets_.size(); ++dir)
             {
-                int neighbor_height = map_data_[nx][ny];
-                if (neighbor_height == current_height + 1)
+                const int next_row = row + kDeltaRow[dir];
+                const int next_col = col + kDeltaCol[dir];
+                if (map_data_[cell + neighbour_offsets_[dir]] == h + 1 && box.Contains(next_row, next_col))
                 {
-                    visited.insert({nx, ny});
-                    queue.push({nx, ny});
+                    peaks.UnionWith(upper_level_[box.Index(next_row, next_col)], tile_words);
                 }
             }
-        }
+        };
+        ForEachCellInBox(h, box, merge_uphill);
+        std::swap(current_level_, upper_level_);
     }
 
-    score = static_cast<int>(reached_nines.size());
+    uint64_t score = 0;
+    auto add_score = [&](uint32_t, uint32_t, int row, int col)
+    {
+        score += upper_level_[box.Index(row, col)].Size();
+    };
+    ForEachCellInBox(kMinHeight, box, add_score);
     return score;
 }
 
-int TopographicMap::CalculateTotalTrailheadScores()
+uint64_t TopographicMap::CalculateTotalTrailheadScores()
 {
-    int total_score = 0;
+    auto [peak_begin, peak_end] = Bucket(kMaxHeight);
+    const size_t peak_count = peak_end - peak_begin;
+    const size_t tile = peak_count <= kSmallTile ? kSmallTile : kLargeTile;
 
-    const auto IsTrailhead = [this](int x, int y)
-    {
-        return map_data_[x][y] == kMinHeight;
-    };
+    NumberPeaks(tile);
 
-    for (int x = 0; x < rows_; ++x)
+    uint64_t total_score = 0;
+    for (size_t first_peak = 0; first_peak < peak_count; first_peak += tile)
     {
-        for (int y = 0; y < cols_; ++y)
-        {
-            if (IsTrailhead(x, y))
-            {
-                total_score += CalculateTrailheadScore({x, y});
-            }
-        }
+        total_score += SweepPeakTile(first_peak, std::min(tile, peak_count - first_peak));
     }
-
     return total_score;
 }
 
@@ -146,7 +417,7 @@ int main()
 {
     const std::string filename = "input.txt";
     auto topo_map = std::make_unique<TopographicMap>(filename);
-    int total_score = topo_map->CalculateTotalTrailheadScores();
+    const uint64_t total_score = topo_map->CalculateTotalTrailheadScores();
     std::cout << total_score << std::endl;
     return 0;
-}
\ No newline at end of file
+}
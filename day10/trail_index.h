@@ -0,0 +1,430 @@
+/**
+ * @file trail_index.h
+ * @brief Resident trail index for Advent of Code 2024 Day 10
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @author Volker Schwaberow <volker@schwaberow.de>
+ * @date 11.12.2024
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <barrier>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Totals over a set of trailheads.
+struct TrailSummary
+{
+    uint64_t trailheads = 0;
+    uint64_t score = 0;   // distinct peaks reachable, summed
+    uint64_t rating = 0;  // distinct hiking trails, summed
+};
+
+// Builds the number of trails from every cell to a peak (paths_to_9) once
+// and answers queries from it. Trailhead scores are computed on the first
+// query that needs one, so rating-only users never pay for them. Terrain
+// edits only recompute the cells whose trails can pass through the edited
+// cell: the cone of cells below it, which is never more than nine steps
+// deep.
+class TrailIndex
+{
+public:
+    static constexpr int kMaxHeight = 9;
+    static constexpr uint8_t kImpassable = 0xFF;
+
+    explicit TrailIndex(std::istream &input, unsigned thread_count = std::thread::hardware_concurrency())
+    {
+        LoadMap(input);
+        thread_count_ = heights_.size() < kParallelCells ? 1 : std::max(1u, thread_count);
+        BuildRatings();
+        for (uint32_t cell = 0; cell < heights_.size(); ++cell)
+        {
+            if (heights_[cell] == 0)
+            {
+                total_.trailheads += 1;
+                total_.rating += ratings_[cell];
+            }
+        }
+    }
+
+    [[nodiscard]] int Rows() const
+    {
+        return rows_;
+    }
+
+    [[nodiscard]] int Cols() const
+    {
+        return cols_;
+    }
+
+    [[nodiscard]] int Height(int row, int col) const
+    {
+        return heights_[CellAt(row, col)];
+    }
+
+    // Whole-map totals, kept up to date across edits.
+    [[nodiscard]] TrailSummary Total() const
+    {
+        EnsureScores();
+        return total_;
+    }
+
+    // Sum of all trailhead ratings, without computing any score.
+    [[nodiscard]] uint64_t TotalRating() const
+    {
+        return total_.rating;
+    }
+
+    // Rating and score of a single cell; both are 0 unless it is a trailhead.
+    [[nodiscard]] uint64_t Rating(int row, int col) const
+    {
+        const uint32_t cell = CellAt(row, col);
+        return heights_[cell] == 0 ? ratings_[cell] : 0;
+    }
+
+    [[nodiscard]] uint64_t Score(int row, int col) const
+    {
+        const uint32_t cell = CellAt(row, col);
+        EnsureScores();
+        return scores_[cell];
+    }
+
+    // Totals over the trailheads in rows [row_begin, row_end) and columns
+    // [col_begin, col_end), in time proportional to the region.
+    [[nodiscard]] TrailSummary Summarize(int row_begin, int col_begin, int row_end, int col_end) const
+    {
+        EnsureScores();
+        TrailSummary summary;
+        for (int row = std::max(row_begin, 0); row < std::min(row_end, rows_); ++row)
+        {
+            for (int col = std::max(col_begin, 0); col < std::min(col_end, cols_); ++col)
+            {
+                const uint32_t cell = CellAt(row, col);
+                if (heights_[cell] == 0)
+                {
+                    summary.trailheads += 1;
+                    summary.score += scores_[cell];
+                    summary.rating += ratings_[cell];
+                }
+            }
+        }
+        return summary;
+    }
+
+    // Changes one cell to a height in 0..9 or to kImpassable and updates
+    // every rating and score that depends on it.
+    void SetHeight(int row, int col, int height)
+    {
+        if (height != kImpassable && (height < 0 || height > kMaxHeight))
+        {
+            throw std::out_of_range("Height out of range");
+        }
+        const uint32_t edited = CellAt(row, col);
+        const uint8_t old_height = heights_[edited];
+        if (old_height == height)
+        {
+            return;
+        }
+
+        // A cell's paths_to_9 and score only change if one of its trails
+        // passes through the edited cell, before or after the edit.
+        std::vector<uint32_t> cone;
+        CollectDownhillCone(edited, cone);
+        heights_[edited] = static_cast<uint8_t>(height);
+        CollectDownhillCone(edited, cone);
+        std::ranges::sort(cone);
+        cone.erase(std::unique(cone.begin(), cone.end()), cone.end());
+
+        heights_[edited] = old_height;
+        for (uint32_t cell : cone)
+        {
+            Retract(cell);
+        }
+        heights_[edited] = static_cast<uint8_t>(height);
+
+        // Highest first, so uphill neighbours inside the cone are already
+        // up to date when a cell sums them.
+        std::ranges::sort(cone, std::ranges::greater{}, [this](uint32_t cell)
+                          { return heights_[cell] == kImpassable ? -1 : static_cast<int>(heights_[cell]); });
+        for (uint32_t cell : cone)
+        {
+            ratings_[cell] = heights_[cell] == kImpassable ? 0 : PathsFrom(cell);
+        }
+        std::vector<uint32_t> level;
+        std::vector<uint32_t> next;
+        for (uint32_t cell : cone)
+        {
+            if (scores_ready_)
+            {
+                scores_[cell] = heights_[cell] == 0 ? CountReachablePeaks(cell, level, next) : 0;
+            }
+            if (heights_[cell] == 0)
+            {
+                total_.trailheads += 1;
+                total_.score += scores_[cell];
+                total_.rating += ratings_[cell];
+            }
+        }
+    }
+
+private:
+    // Below this many cells, starting threads costs more than the DP itself.
+    static constexpr size_t kParallelCells = size_t{1} << 20;
+
+    int rows_ = 0;
+    int cols_ = 0;
+    int stride_ = 0;
+    unsigned thread_count_ = 1;
+    std::array<int, 4> offsets_{};
+
+    // Row-major heights with a one-cell border of kImpassable, so
+    // neighbours never need a bounds check.
+    std::vector<uint8_t> heights_;
+    std::vector<uint64_t> ratings_;
+    // At most 36 peaks lie exactly nine steps away, so a byte suffices.
+    // Filled on first use; total_.score is only valid once scores_ready_.
+    mutable std::vector<uint8_t> scores_;
+    mutable TrailSummary total_;
+    mutable std::once_flag scores_once_;
+    mutable bool scores_ready_ = false;
+
+    [[nodiscard]] uint32_t CellAt(int row, int col) const
+    {
+        if (row < 0 || row >= rows_ || col < 0 || col >= cols_)
+        {
+            throw std::out_of_range("Cell outside of the map");
+        }
+        return static_cast<uint32_t>((row + 1) * stride_ + col + 1);
+    }
+
+    void LoadMap(std::istream &input)
+    {
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(input, line))
+        {
+            if (!line.empty())
+            {
+                cols_ = std::max(cols_, static_cast<int>(line.size()));
+                lines.push_back(std::move(line));
+            }
+        }
+        rows_ = static_cast<int>(lines.size());
+        stride_ = cols_ + 2;
+        offsets_ = {-stride_, stride_, -1, 1};
+
+        // Anything that is not a digit is impassable.
+        heights_.assign(static_cast<size_t>(rows_ + 2) * stride_, kImpassable);
+        for (int row = 0; row < rows_; ++row)
+        {
+            for (int col = 0; col < static_cast<int>(lines[row].size()); ++col)
+            {
+                const char ch = lines[row][col];
+                if (ch >= '0' && ch <= '9')
+                {
+                    heights_[static_cast<size_t>(row + 1) * stride_ + col + 1] = static_cast<uint8_t>(ch - '0');
+                }
+            }
+        }
+        ratings_.assign(heights_.size(), 0);
+        scores_.assign(heights_.size(), 0);
+    }
+
+    [[nodiscard]] uint64_t PathsFrom(uint32_t cell) const
+    {
+        const int height = heights_[cell];
+        if (height == kMaxHeight)
+        {
+            return 1;
+        }
+        uint64_t total_paths = 0;
+        for (int offset : offsets_)
+        {
+            if (heights_[cell + offset] == height + 1)
+            {
+                total_paths += ratings_[cell + offset];
+            }
+        }
+        return total_paths;
+    }
+
+    // Counting sort of the cells by height, then the DP bucket by bucket
+    // from the peaks down. Cells of one height only read cells of the next
+    // height up, so each level is split into contiguous slices, one per
+    // thread, with a barrier before the next level starts.
+    void BuildRatings()
+    {
+        const unsigned thread_count = thread_count_;
+        std::array<uint32_t, kMaxHeight + 2> bucket_start{};
+        for (uint8_t height : heights_)
+        {
+            if (height <= kMaxHeight)
+            {
+                ++bucket_start[height + 1];
+            }
+        }
+        for (int h = 0; h <= kMaxHeight; ++h)
+        {
+            bucket_start[h + 1] += bucket_start[h];
+        }
+        std::vector<uint32_t> by_height(bucket_start[kMaxHeight + 1]);
+        std::array<uint32_t, kMaxHeight + 1> next{};
+        std::copy_n(bucket_start.begin(), next.size(), next.begin());
+        for (uint32_t cell = 0; cell < heights_.size(); ++cell)
+        {
+            if (heights_[cell] <= kMaxHeight)
+            {
+                by_height[next[heights_[cell]]++] = cell;
+            }
+        }
+
+        std::barrier level_done(thread_count);
+
+        auto worker = [&](unsigned id)
+        {
+            for (int h = kMaxHeight; h >= 0; --h)
+            {
+                const uint64_t level_size = bucket_start[h + 1] - bucket_start[h];
+                const uint32_t begin = bucket_start[h] + static_cast<uint32_t>(level_size * id / thread_count);
+                const uint32_t end = bucket_start[h] + static_cast<uint32_t>(level_size * (id + 1) / thread_count);
+                for (uint32_t k = begin; k < end; ++k)
+                {
+                    ratings_[by_height[k]] = PathsFrom(by_height[k]);
+                }
+                level_done.arrive_and_wait();
+            }
+        };
+
+        RunOnThreads(thread_count, worker);
+    }
+
+    template <typename Worker>
+    static void RunOnThreads(unsigned thread_count, Worker &worker)
+    {
+        std::vector<std::jthread> threads;
+        for (unsigned id = 1; id < thread_count; ++id)
+        {
+            threads.emplace_back(std::ref(worker), id);
+        }
+        worker(0);
+    }
+
+    void EnsureScores() const
+    {
+        std::call_once(scores_once_, [this]
+                       { ComputeScores(); });
+    }
+
+    // Scores every trailhead, each thread over its own contiguous slice of
+    // the map with its own scratch buffers.
+    void ComputeScores() const
+    {
+        const unsigned thread_count = thread_count_;
+        std::vector<uint64_t> partial_scores(thread_count, 0);
+
+        auto worker = [&](unsigned id)
+        {
+            const size_t begin = heights_.size() * id / thread_count;
+            const size_t end = heights_.size() * (id + 1) / thread_count;
+            std::vector<uint32_t> level;
+            std::vector<uint32_t> next;
+            uint64_t score = 0;
+            for (size_t cell = begin; cell < end; ++cell)
+            {
+                if (heights_[cell] == 0)
+                {
+                    scores_[cell] = CountReachablePeaks(static_cast<uint32_t>(cell), level, next);
+                    score += scores_[cell];
+                }
+            }
+            partial_scores[id] = score;
+        };
+        RunOnThreads(thread_count, worker);
+
+        for (uint64_t score : partial_scores)
+        {
+            total_.score += score;
+        }
+        scores_ready_ = true;
+    }
+
+    // Distinct peaks reachable from a cell, walking up one level at a time.
+    // A level holds at most 4 * distance cells, so deduplicating it by
+    // sorting is cheaper than a visited array over the whole map. level and
+    // next are scratch buffers owned by the caller.
+    [[nodiscard]] uint8_t CountReachablePeaks(uint32_t start, std::vector<uint32_t> &level,
+                                              std::vector<uint32_t> &next) const
+    {
+        level.assign(1, start);
+        for (int h = heights_[start]; h < kMaxHeight && !level.empty(); ++h)
+        {
+            next.clear();
+            for (uint32_t cell : level)
+            {
+                for (int offset : offsets_)
+                {
+                    if (heights_[cell + offset] == h + 1)
+                    {
+                        next.push_back(cell + offset);
+                    }
+                }
+            }
+            std::ranges::sort(next);
+            next.erase(std::unique(next.begin(), next.end()), next.end());
+            std::swap(level, next);
+        }
+        return static_cast<uint8_t>(level.size());
+    }
+
+    // Appends the cell and every cell with a trail leading up into it,
+    // one level at a time so that each cell is added once.
+    void CollectDownhillCone(uint32_t top, std::vector<uint32_t> &cone) const
+    {
+        std::vector<uint32_t> level{top};
+        std::vector<uint32_t> next;
+        for (int h = heights_[top]; !level.empty(); --h)
+        {
+            cone.insert(cone.end(), level.begin(), level.end());
+            next.clear();
+            if (h >= 1 && h <= kMaxHeight)
+            {
+                for (uint32_t cell : level)
+                {
+                    for (int offset : offsets_)
+                    {
+                        if (heights_[cell + offset] == h - 1)
+                        {
+                            next.push_back(cell + offset);
+                        }
+                    }
+                }
+            }
+            std::ranges::sort(next);
+            next.erase(std::unique(next.begin(), next.end()), next.end());
+            std::swap(level, next);
+        }
+    }
+
+    // Removes a trailhead's contribution from the totals before its values
+    // are recomputed.
+    void Retract(uint32_t cell)
+    {
+        if (heights_[cell] == 0)
+        {
+            total_.trailheads -= 1;
+            total_.score -= scores_[cell];
+            total_.rating -= ratings_[cell];
+        }
+    }
+};
@@ -8,18 +8,43 @@
  * @date 11.12.2024
  */
 
-#include <algorithm>
 #include <cstdint>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
-#include <iterator>
-#include <memory>
-#include <optional>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 
-using StoneNumber = std::string;
+#include "stone_number.h"
+
+// All stones in their original order, split by representation. Only the
+// count matters, so keeping the rare big stones apart is fine.
+struct StoneRow
+{
+    std::vector<uint64_t> small;
+    std::vector<BigStone> big;
+
+    void Clear()
+    {
+        small.clear();
+        big.clear();
+    }
+
+    [[nodiscard]] size_t Size() const
+    {
+        return small.size() + big.size();
+    }
+
+    [[nodiscard]] auto Appender()
+    {
+        return StoneSink{[this](uint64_t stone)
+                         { small.push_back(stone); },
+                         [this](BigStone &&stone)
+                         { big.push_back(std::move(stone)); }};
+    }
+};
 
 class InputReader
 {
@@ -35,13 +60,13 @@ public:
 
     ~InputReader() { file_stream_.close(); }
 
-    std::vector<StoneNumber> ReadInitialStones()
+    StoneRow ReadInitialStones()
     {
-        std::vector<StoneNumber> stones;
+        StoneRow stones;
         std::string number;
         while (file_stream_ >> number)
         {
-            stones.push_back(number);
+            ParseStone(number, stones.Appender());
         }
         return stones;
     }
@@ -50,91 +75,34 @@ private:
     std::ifstream file_stream_;
 };
 
-std::pair<StoneNumber, StoneNumber> SplitStone(const StoneNumber &number)
-{
-    size_t length = number.size();
-    size_t half = length / 2;
-    StoneNumber left = number.substr(0, half);
-    StoneNumber right = number.substr(half);
-    left.erase(0, left.find_first_not_of('0'));
-    right.erase(0, right.find_first_not_of('0'));
-
-    if (left.empty())
-        left = "0";
-    if (right.empty())
-        right = "0";
-    return {left, right};
-}
-
-std::vector<StoneNumber> TransformStone(const StoneNumber &stone_number)
-{
-    if (stone_number == "0")
-    {
-        return {"1"};
-    }
-
-    if (stone_number.size() % 2 == 0)
-    {
-        auto [left, right] = SplitStone(stone_number);
-        return {std::move(left), std::move(right)};
-    }
-
-    auto MultiplyBy2024 = [](const StoneNumber &num_str) -> StoneNumber
-    {
-        std::vector<int> digits;
-        for (char c : num_str)
-        {
-            digits.push_back(c - '0');
-        }
-        std::reverse(digits.begin(), digits.end());
-
-        int multiplier = 2024;
-        std::vector<int> result;
-        int carry = 0;
-        for (size_t i = 0; i < digits.size(); ++i)
-        {
-            int prod = digits[i] * multiplier + carry;
-            result.push_back(prod % 10);
-            carry = prod / 10;
-        }
-        while (carry > 0)
-        {
-            result.push_back(carry % 10);
-            carry /= 10;
-        }
-        StoneNumber product;
-        std::for_each(result.rbegin(), result.rend(),
-                      [&product](int digit)
-                      { product.push_back('0' + digit); });
-        return product;
-    };
-
-    StoneNumber new_stone = MultiplyBy2024(stone_number);
-    return {std::move(new_stone)};
-}
-
 int main()
 {
     try
     {
         InputReader reader("input.txt");
-        std::vector<StoneNumber> stones = reader.ReadInitialStones();
+        StoneRow stones = reader.ReadInitialStones();
+        StoneRow new_stones;
 
         constexpr int kTotalBlinks = 25;
 
         for (int blink = 0; blink < kTotalBlinks; ++blink)
         {
-            std::vector<StoneNumber> new_stones;
-            new_stones.reserve(stones.size() * 2);
-
-            std::for_each(stones.begin(), stones.end(), [&new_stones](const StoneNumber &stone)
-                          {
-        auto transformed = TransformStone(stone);
-        new_stones.insert(new_stones.end(), transformed.begin(), transformed.end()); });
-            stones = std::move(new_stones);
+            new_stones.Clear();
+            new_stones.small.reserve(stones.Size() * 2);
+
+            auto append = new_stones.Appender();
+            for (uint64_t stone : stones.small)
+            {
+                BlinkStone(stone, append);
+            }
+            for (const BigStone &stone : stones.big)
+            {
+                BlinkStone(stone, append);
+            }
+            std::swap(stones, new_stones);
         }
 
-        std::cout << "After " << kTotalBlinks << " blinks, there are " << stones.size()
+        std::cout << "After " << kTotalBlinks << " blinks, there are " << stones.Size()
                   << " stones." << std::endl;
     }
     catch (const std::exception &e)
@@ -144,4 +112,4 @@ int main()
     }
 
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -8,40 +8,133 @@
  * @date 11.12.2024
  */
 
+#include <algorithm>
+#include <bit>
 #include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <string>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
-auto BigMultiply = [](const std::string &number_str, int multiplier) -> std::string
+#include "stone_number.h"
+
+// Stone counts keyed by number: a flat, linear-probing hash table. A count
+// of zero marks an empty slot, so every 64-bit number is a valid key.
+// Clearing keeps the slots, and the table only grows when it would become
+// more than half full.
+class StoneTable
 {
-    std::string result;
-    int carry = 0;
-    for (auto it = number_str.rbegin(); it != number_str.rend(); ++it)
+public:
+    explicit StoneTable(size_t capacity = kInitialCapacity)
+    {
+        Rehash(std::bit_ceil(std::max<size_t>(capacity, 2)));
+    }
+
+    void Clear()
+    {
+        std::fill(counts_.begin(), counts_.end(), 0);
+        size_ = 0;
+    }
+
+    void Add(uint64_t stone, int64_t count)
+    {
+        if ((size_ + 1) * 2 > keys_.size())
+        {
+            Rehash(keys_.size() * 2);
+        }
+
+        size_t slot = Slot(stone);
+        while (counts_[slot] != 0 && keys_[slot] != stone)
+        {
+            slot = (slot + 1) & (keys_.size() - 1);
+        }
+        if (counts_[slot] == 0)
+        {
+            keys_[slot] = stone;
+            ++size_;
+        }
+        counts_[slot] += count;
+    }
+
+    template <typename Visitor>
+    void ForEach(Visitor visitor) const
     {
-        int digit = *it - '0';
-        int temp = digit * multiplier + carry;
-        carry = temp / 10;
-        temp %= 10;
-        result.insert(result.begin(), temp + '0');
+        for (size_t slot = 0; slot < keys_.size(); ++slot)
+        {
+            if (counts_[slot] != 0)
+            {
+                visitor(keys_[slot], counts_[slot]);
+            }
+        }
     }
-    while (carry > 0)
+
+private:
+    static constexpr size_t kInitialCapacity = 1024;
+
+    std::vector<uint64_t> keys_;
+    std::vector<int64_t> counts_;
+    size_t size_ = 0;
+    int shift_ = 0;
+
+    // Fibonacci hashing: the top bits of key * 2^64 / phi.
+    [[nodiscard]] size_t Slot(uint64_t stone) const
     {
-        result.insert(result.begin(), (carry % 10) + '0');
-        carry /= 10;
+        return static_cast<size_t>((stone * 0x9E3779B97F4A7C15ULL) >> shift_);
+    }
+
+    void Rehash(size_t capacity)
+    {
+        std::vector<uint64_t> old_keys(capacity, 0);
+        std::vector<int64_t> old_counts(capacity, 0);
+        std::swap(keys_, old_keys);
+        std::swap(counts_, old_counts);
+        shift_ = 64 - std::countr_zero(capacity);
+        size_ = 0;
+
+        for (size_t slot = 0; slot < old_keys.size(); ++slot)
+        {
+            if (old_counts[slot] != 0)
+            {
+                Add(old_keys[slot], old_counts[slot]);
+            }
+        }
     }
-    return result;
 };
 
-auto StripLeadingZeros = [](const std::string &str) -> std::string
+// Number of stones per engraved number. Stones that outgrow 64 bits are
+// counted in a separate ordered map; they rarely appear at all.
+struct StoneCounts
 {
-    size_t non_zero_pos = str.find_first_not_of('0');
-    if (non_zero_pos == std::string::npos)
+    StoneTable small;
+    std::map<BigStone, int64_t> big;
+
+    void Clear()
     {
-        return "0";
+        small.Clear();
+        big.clear();
+    }
+
+    [[nodiscard]] auto Adder(int64_t count)
+    {
+        return StoneSink{[this, count](uint64_t stone)
+                         { small.Add(stone, count); },
+                         [this, count](BigStone &&stone)
+                         { big[std::move(stone)] += count; }};
+    }
+
+    [[nodiscard]] int64_t Total() const
+    {
+        int64_t total = 0;
+        small.ForEach([&](uint64_t, int64_t count)
+                      { total += count; });
+        for (const auto &[_, count] : big)
+        {
+            total += count;
+        }
+        return total;
     }
-    return str.substr(non_zero_pos);
 };
 
 int main()
@@ -53,50 +146,32 @@ int main()
         return 1;
     }
 
-    std::unordered_map<std::string, int64_t> stones;
+    StoneCounts stones;
 
     std::string number;
     while (input_file >> number)
     {
-        stones[StripLeadingZeros(number)] += 1;
+        ParseStone(number, stones.Adder(1));
     }
 
+    // The two tables swap roles every blink, so once both have grown to
+    // the number of distinct stones, blinking allocates nothing.
+    StoneCounts new_stones;
     const int total_blinks = 75;
     for (int blink = 0; blink < total_blinks; ++blink)
     {
-        std::unordered_map<std::string, int64_t> new_stones;
+        new_stones.Clear();
 
-        for (const auto &[number_str, count] : stones)
+        stones.small.ForEach([&](uint64_t stone, int64_t count)
+                             { BlinkStone(stone, new_stones.Adder(count)); });
+        for (const auto &[stone, count] : stones.big)
         {
-            if (number_str == "0")
-            {
-                new_stones["1"] += count;
-            }
-            else if (number_str.length() % 2 == 0)
-            {
-                size_t mid = number_str.length() / 2;
-                std::string left_str = StripLeadingZeros(number_str.substr(0, mid));
-                std::string right_str = StripLeadingZeros(number_str.substr(mid));
-
-                new_stones[left_str] += count;
-                new_stones[right_str] += count;
-            }
-            else
-            {
-                std::string new_number = BigMultiply(number_str, 2024);
-                new_stones[new_number] += count;
-            }
+            BlinkStone(stone, new_stones.Adder(count));
         }
 
-        stones = std::move(new_stones);
-    }
-
-    int64_t total_stones = 0;
-    for (const auto &[_, count] : stones)
-    {
-        total_stones += count;
+        std::swap(stones, new_stones);
     }
 
-    std::cout << total_stones << std::endl;
+    std::cout << stones.Total() << std::endl;
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,240 @@
+/**
+ * @file stone_number.h
+ * @brief Integer stone numbers shared by both parts of Advent of Code 2024 Day 11
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @author Volker Schwaberow <volker@schwaberow.de>
+ * @date 11.12.2024
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <compare>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+constexpr uint64_t kStoneMultiplier = 2024;
+
+constexpr std::array<uint64_t, 20> kPowersOfTen = []
+{
+    std::array<uint64_t, 20> powers{};
+    powers[0] = 1;
+    for (size_t i = 1; i < powers.size(); ++i)
+    {
+        powers[i] = powers[i - 1] * 10;
+    }
+    return powers;
+}();
+
+// Number of decimal digits, from log10(2) * bit_width (1233 / 4096) and
+// one correction against the power-of-ten table.
+constexpr int DigitCount(uint64_t value)
+{
+    const int estimate = (std::bit_width(value) * 1233) >> 12;
+    return std::max(1, estimate + (value >= kPowersOfTen[estimate] ? 1 : 0));
+}
+
+// Stones that no longer fit into 64 bits. They are rare, so the
+// representation is simply base 10^9 limbs, least significant first, with
+// no leading zero limbs.
+class BigStone
+{
+public:
+    explicit BigStone(uint64_t value)
+    {
+        while (value > 0)
+        {
+            limbs_.push_back(static_cast<uint32_t>(value % kLimbBase));
+            value /= kLimbBase;
+        }
+    }
+
+    // Parses a run of decimal digits of any length.
+    static BigStone Parse(std::string_view digits)
+    {
+        BigStone stone(0);
+        while (!digits.empty())
+        {
+            const size_t limb_digits = std::min<size_t>(kLimbDigits, digits.size());
+            uint32_t limb = 0;
+            const std::string_view chunk = digits.substr(digits.size() - limb_digits);
+            const auto [end, error] = std::from_chars(chunk.data(), chunk.data() + chunk.size(), limb);
+            if (error != std::errc() || end != chunk.data() + chunk.size())
+            {
+                throw std::runtime_error("Invalid stone number");
+            }
+            stone.limbs_.push_back(limb);
+            digits.remove_suffix(limb_digits);
+        }
+        stone.Trim();
+        return stone;
+    }
+
+    [[nodiscard]] int DigitCount() const
+    {
+        return limbs_.empty() ? 1 : kLimbDigits * static_cast<int>(limbs_.size() - 1) + ::DigitCount(limbs_.back());
+    }
+
+    [[nodiscard]] BigStone MultipliedBy(uint64_t factor) const
+    {
+        BigStone product(0);
+        product.limbs_.reserve(limbs_.size() + 2);
+        uint64_t carry = 0;
+        for (uint32_t limb : limbs_)
+        {
+            const uint64_t value = limb * factor + carry;
+            product.limbs_.push_back(static_cast<uint32_t>(value % kLimbBase));
+            carry = value / kLimbBase;
+        }
+        while (carry > 0)
+        {
+            product.limbs_.push_back(static_cast<uint32_t>(carry % kLimbBase));
+            carry /= kLimbBase;
+        }
+        return product;
+    }
+
+    // The value as (value / 10^digits, value % 10^digits).
+    [[nodiscard]] std::pair<BigStone, BigStone> Split(int digits) const
+    {
+        const size_t limb_shift = static_cast<size_t>(digits / kLimbDigits);
+        const uint32_t divisor = static_cast<uint32_t>(kPowersOfTen[digits % kLimbDigits]);
+
+        BigStone low(0);
+        low.limbs_.assign(limbs_.begin(), limbs_.begin() + static_cast<std::ptrdiff_t>(std::min(limb_shift, limbs_.size())));
+        if (limb_shift < limbs_.size())
+        {
+            low.limbs_.push_back(limbs_[limb_shift] % divisor);
+        }
+        low.Trim();
+
+        BigStone high(0);
+        for (size_t i = limb_shift; i < limbs_.size(); ++i)
+        {
+            const uint32_t above = i + 1 < limbs_.size() ? limbs_[i + 1] % divisor : 0;
+            high.limbs_.push_back(limbs_[i] / divisor + above * (kLimbBase / divisor));
+        }
+        high.Trim();
+
+        return {std::move(high), std::move(low)};
+    }
+
+    // The value as a 64-bit integer, if it fits.
+    [[nodiscard]] bool Narrow(uint64_t &value) const
+    {
+        value = 0;
+        for (auto limb = limbs_.rbegin(); limb != limbs_.rend(); ++limb)
+        {
+            if (__builtin_mul_overflow(value, kLimbBase, &value) ||
+                __builtin_add_overflow(value, *limb, &value))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Orders by limbs, which is all a map key needs.
+    auto operator<=>(const BigStone &) const = default;
+
+private:
+    static constexpr int kLimbDigits = 9;
+    static constexpr uint32_t kLimbBase = 1'000'000'000;
+
+    std::vector<uint32_t> limbs_;
+
+    void Trim()
+    {
+        while (!limbs_.empty() && limbs_.back() == 0)
+        {
+            limbs_.pop_back();
+        }
+    }
+};
+
+// Hands `sink` the stones that `stone` turns into after one blink. Stones
+// are passed as uint64_t while they fit, and as BigStone otherwise.
+template <typename Sink>
+void BlinkStone(uint64_t stone, Sink &&sink)
+{
+    if (stone == 0)
+    {
+        sink(uint64_t{1});
+        return;
+    }
+
+    const int digits = DigitCount(stone);
+    if (digits % 2 == 0)
+    {
+        const uint64_t divisor = kPowersOfTen[digits / 2];
+        sink(stone / divisor);
+        sink(stone % divisor);
+        return;
+    }
+
+    uint64_t product = 0;
+    if (__builtin_mul_overflow(stone, kStoneMultiplier, &product))
+    {
+        sink(BigStone(stone).MultipliedBy(kStoneMultiplier));
+        return;
+    }
+    sink(product);
+}
+
+template <typename Sink>
+void BlinkStone(const BigStone &stone, Sink &&sink)
+{
+    const int digits = stone.DigitCount();
+    if (digits % 2 != 0)
+    {
+        sink(stone.MultipliedBy(kStoneMultiplier));
+        return;
+    }
+
+    auto [high, low] = stone.Split(digits / 2);
+    for (BigStone *half : {&high, &low})
+    {
+        uint64_t value = 0;
+        if (half->Narrow(value))
+        {
+            sink(value);
+        }
+        else
+        {
+            sink(std::move(*half));
+        }
+    }
+}
+
+// Combines lambdas into one sink with an overload per stone type.
+template <typename... Handlers>
+struct StoneSink : Handlers...
+{
+    using Handlers::operator()...;
+};
+
+// Reads one stone, however many digits it has.
+template <typename Sink>
+void ParseStone(std::string_view digits, Sink &&sink)
+{
+    uint64_t value = 0;
+    const auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+    if (error == std::errc() && end == digits.data() + digits.size())
+    {
+        sink(value);
+        return;
+    }
+    if (error != std::errc::result_out_of_range)
+    {
+        throw std::runtime_error("Invalid stone number");
+    }
+    sink(BigStone::Parse(digits));
+}
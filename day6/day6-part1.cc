@@ -8,23 +8,15 @@
  * @date 06.12.2024
  */
 
+#include <cstdint>
 #include <fstream>
 #include <iostream>
-#include <unordered_set>
 #include <vector>
 #include <string>
 #include <tuple>
 #include <stdexcept>
 #include <chrono>
 
-struct PairHash
-{
-    std::size_t operator()(const std::pair<int, int> &p) const noexcept
-    {
-        return std::hash<int>()(p.first) ^ (std::hash<int>()(p.second) << 1);
-    }
-};
-
 enum class Direction
 {
     kUp,
@@ -44,7 +36,8 @@ public:
 
     [[nodiscard]] std::size_t SimulateGuardPath()
     {
-        visited_positions_.insert({guard_x_, guard_y_});
+        visited_.assign(map_.size() * map_[0].size(), 0);
+        MarkVisited(guard_x_, guard_y_);
 
         while (true)
         {
@@ -61,18 +54,26 @@ public:
             {
                 guard_x_ = next_x;
                 guard_y_ = next_y;
-                visited_positions_.insert({guard_x_, guard_y_});
+                MarkVisited(guard_x_, guard_y_);
             }
         }
 
-        return visited_positions_.size();
+        return visited_count_;
     }
 
 private:
     std::vector<std::string> map_;
     int guard_x_ = 0, guard_y_ = 0;
     Direction guard_dir_ = Direction::kUp;
-    std::unordered_set<std::pair<int, int>, PairHash> visited_positions_;
+    std::vector<std::uint8_t> visited_;
+    std::size_t visited_count_ = 0;
+
+    void MarkVisited(int x, int y)
+    {
+        std::uint8_t &cell = visited_[static_cast<std::size_t>(x) * map_[0].size() + y];
+        visited_count_ += cell == 0;
+        cell = 1;
+    }
 
     void LoadMap(const std::string &filename)
     {
@@ -8,68 +8,107 @@
  * @date 06.12.2024
  */
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <expected>
 #include <format>
 #include <fstream>
 #include <iostream>
-#include <map>
-#include <queue>
+#include <numeric>
 #include <ranges>
-#include <set>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <utility>
-#include <variant>
 #include <vector>
 
 class MazePathFinder
 {
 public:
     using Position = std::pair<int, int>;
-    using QueueItem = std::tuple<int, int, int, int>;
 
-    explicit MazePathFinder(std::string_view filename)
+    explicit MazePathFinder(std::string_view filename,
+                            unsigned thread_count = std::thread::hardware_concurrency())
+        : thread_count_(std::max(thread_count, 1u))
     {
         LoadMap(filename);
-        InitializeDirections();
+        BuildJumpTables();
     }
 
-    [[nodiscard]] int SolvePart2()
+    [[nodiscard]] int SolvePart2() const
     {
-        int blocked_paths = 0;
-        std::vector<Position> positions;
+        // An obstacle can only change the patrol if the guard would walk
+        // into it, so the unobstructed route is the full candidate set
+        // unless that route is itself a loop.
+        const std::vector<Candidate> candidates = TraceRoute();
 
-        for (const auto &[pos, _] : map_)
-        {
-            positions.push_back(pos);
-        }
-
-        auto map_copy = map_;
+        // Loop lengths differ wildly between candidates, so workers pull
+        // small chunks from a shared cursor instead of fixed slices.
+        std::atomic<std::size_t> next_candidate{0};
+        std::vector<int> blocked_paths(thread_count_, 0);
 
-        for (const auto &pos : positions)
+        auto worker = [&](unsigned id)
         {
-            map_ = map_copy;
-
-            if (map_[pos] == '^' || map_[pos] == '#')
+            int blocked = 0;
+            while (true)
             {
-                continue;
-            }
+                const std::size_t begin = next_candidate.fetch_add(kChunkSize, std::memory_order_relaxed);
+                if (begin >= candidates.size())
+                {
+                    break;
+                }
 
-            map_[pos] = '#';
-            seen_.clear();
-            seen_.insert({start_.first, start_.second, 0, 0});
+                const std::size_t end = std::min(begin + kChunkSize, candidates.size());
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    blocked += FindPath(candidates[i]) ? 1 : 0;
+                }
+            }
+            blocked_paths[id] = blocked;
+        };
 
-            blocked_paths += std::get<int>(FindPath(false));
+        std::vector<std::jthread> threads;
+        for (unsigned id = 1; id < thread_count_; ++id)
+        {
+            threads.emplace_back(worker, id);
         }
+        worker(0);
+        threads.clear();
 
-        return blocked_paths;
+        return std::accumulate(blocked_paths.begin(), blocked_paths.end(), 0);
     }
 
 private:
-    std::map<Position, char> map_;
+    static constexpr std::array<int, 4> kDeltaRow{-1, 0, 1, 0};
+    static constexpr std::array<int, 4> kDeltaCol{0, 1, 0, -1};
+    static constexpr std::uint32_t kExit = UINT32_MAX;
+    static constexpr std::size_t kChunkSize = 16;
+
+    // A state is a cell index times four plus the heading.
+    using State = std::uint64_t;
+    static constexpr State kExitState = UINT64_MAX;
+
+    // A cell on the unobstructed route together with the state the guard
+    // is in right before it first steps onto that cell. The prefix of the
+    // route up to that state is the same whether or not the cell is blocked.
+    struct Candidate
+    {
+        std::uint32_t cell;
+        State predecessor;
+    };
+
+    std::vector<std::uint8_t> map_;
+    int rows_ = 0;
+    int cols_ = 0;
     Position start_;
-    mutable std::set<QueueItem> seen_;
-    std::map<Position, Position> directions_;
+    unsigned thread_count_;
+
+    // jump_[dir][cell] is the last free cell the guard reaches when walking
+    // from cell towards dir, i.e. where it will turn, or kExit if it leaves
+    // the map. Entries of '#' cells are unused.
+    std::array<std::vector<std::uint32_t>, 4> jump_;
 
     void LoadMap(std::string_view filename)
     {
@@ -80,70 +119,223 @@ private:
         }
 
         std::string line;
-        int row = 0;
-
         while (std::getline(file, line))
         {
-            for (size_t col = 0; col < line.length(); ++col)
+            if (line.empty())
+            {
+                continue;
+            }
+            if (cols_ == 0)
             {
-                map_[{row, col}] = line[col];
+                cols_ = static_cast<int>(line.length());
+            }
+            else if (static_cast<int>(line.length()) != cols_)
+            {
+                throw std::runtime_error(std::format("Row {} has inconsistent width", rows_));
+            }
+
+            for (int col = 0; col < cols_; ++col)
+            {
+                map_.push_back(static_cast<std::uint8_t>(line[col]));
                 if (line[col] == '^')
                 {
-                    start_ = {row, col};
+                    start_ = {rows_, col};
                 }
             }
-            ++row;
+            ++rows_;
         }
     }
 
-    void InitializeDirections()
+    [[nodiscard]] std::size_t Index(int row, int col) const
+    {
+        return static_cast<std::size_t>(row) * cols_ + col;
+    }
+
+    [[nodiscard]] bool IsWithinBounds(int row, int col) const
+    {
+        return row >= 0 && row < rows_ && col >= 0 && col < cols_;
+    }
+
+    void BuildJumpTables()
     {
-        directions_ = {
-            {{-1, 0}, {0, 1}},
-            {{0, 1}, {1, 0}},
-            {{1, 0}, {0, -1}},
-            {{0, -1}, {-1, 0}}};
+        for (int dir = 0; dir < 4; ++dir)
+        {
+            jump_[dir].assign(map_.size(), kExit);
+
+            // Sweep every row or column starting from the edge the guard
+            // walks towards, carrying the current run's stopping cell.
+            const int step_row = -kDeltaRow[dir];
+            const int step_col = -kDeltaCol[dir];
+            const int lines = step_row != 0 ? cols_ : rows_;
+
+            for (int line = 0; line < lines; ++line)
+            {
+                int row = step_row != 0 ? (step_row > 0 ? 0 : rows_ - 1) : line;
+                int col = step_col != 0 ? (step_col > 0 ? 0 : cols_ - 1) : line;
+                std::uint32_t target = kExit;
+                bool after_obstacle = false;
+
+                for (; IsWithinBounds(row, col); row += step_row, col += step_col)
+                {
+                    const std::size_t cell = Index(row, col);
+                    if (map_[cell] == '#')
+                    {
+                        after_obstacle = true;
+                        continue;
+                    }
+                    if (after_obstacle)
+                    {
+                        target = static_cast<std::uint32_t>(cell);
+                        after_obstacle = false;
+                    }
+                    jump_[dir][cell] = target;
+                }
+            }
+        }
     }
 
-    [[nodiscard]] std::variant<int, std::set<QueueItem>> FindPath(bool is_part1) const
+    [[nodiscard]] std::vector<Candidate> TraceRoute() const
     {
-        std::queue<QueueItem> queue;
-        queue.push({start_.first, start_.second, -1, 0});
+        std::vector<Candidate> candidates;
+        std::vector<std::uint8_t> headings(map_.size(), 0);
+        auto [row, col] = start_;
+        int dir = 0;
 
-        while (!queue.empty())
+        while (true)
         {
-            auto [row, col, delta_row, delta_col] = queue.front();
-            queue.pop();
+            const std::size_t cell = Index(row, col);
+            const std::uint8_t heading = static_cast<std::uint8_t>(1u << dir);
 
-            if (!is_part1 && seen_.contains({row, col, delta_row, delta_col}))
+            if (headings[cell] & heading)
             {
-                return 1;
+                return FreeCells();
             }
+            headings[cell] |= heading;
 
-            is_part1 ? seen_.insert({row, col, 0, 0})
-                     : seen_.insert({row, col, delta_row, delta_col});
+            const int next_row = row + kDeltaRow[dir];
+            const int next_col = col + kDeltaCol[dir];
 
-            int next_row = row + delta_row;
-            int next_col = col + delta_col;
-            Position next_pos = {next_row, next_col};
+            if (!IsWithinBounds(next_row, next_col))
+            {
+                return candidates;
+            }
 
-            if (!map_.contains(next_pos))
+            const std::size_t next_cell = Index(next_row, next_col);
+            if (map_[next_cell] == '#')
             {
-                return is_part1 ? std::variant<int, std::set<QueueItem>>{seen_} : 0;
+                dir = (dir + 1) % 4;
+                continue;
             }
 
-            if (map_.at(next_pos) == '#')
+            if (headings[next_cell] == 0 && map_[next_cell] == '.')
             {
-                auto [next_delta_row, next_delta_col] = directions_.at({delta_row, delta_col});
-                queue.push({row, col, next_delta_row, next_delta_col});
+                candidates.push_back({static_cast<std::uint32_t>(next_cell), cell * 4 + dir});
             }
-            else
+            row = next_row;
+            col = next_col;
+        }
+    }
+
+    // Every free cell, each resumed from the start state. Used when the
+    // unobstructed guard already loops, since then the route alone is not
+    // the full candidate set.
+    [[nodiscard]] std::vector<Candidate> FreeCells() const
+    {
+        std::vector<Candidate> candidates;
+        const State start = Index(start_.first, start_.second) * 4;
+        for (std::size_t cell = 0; cell < map_.size(); ++cell)
+        {
+            if (map_[cell] == '.')
             {
-                queue.push({next_row, next_col, delta_row, delta_col});
+                candidates.push_back({static_cast<std::uint32_t>(cell), start});
             }
         }
+        return candidates;
+    }
+
+    // Advances from `state` to the state right after the guard's next turn,
+    // treating `obstacle` as an extra '#' that cuts a jump-table segment
+    // short when it lies on it. Returns kExitState if the guard leaves.
+    [[nodiscard]] State NextTurn(State state, int obstacle_row, int obstacle_col) const
+    {
+        const std::size_t cell = state / 4;
+        const int dir = static_cast<int>(state % 4);
+        const int row = static_cast<int>(cell / cols_);
+        const int col = static_cast<int>(cell % cols_);
+
+        const std::uint32_t target = jump_[dir][cell];
+        const int target_row = target == kExit ? -1 : static_cast<int>(target / cols_);
+        const int target_col = target == kExit ? -1 : static_cast<int>(target % cols_);
+
+        std::size_t stop = target;
+        if (HitsObstacle(row, col, dir, obstacle_row, obstacle_col, target, target_row, target_col))
+        {
+            stop = Index(obstacle_row - kDeltaRow[dir], obstacle_col - kDeltaCol[dir]);
+        }
+        else if (target == kExit)
+        {
+            return kExitState;
+        }
+
+        return stop * 4 + (dir + 1) % 4;
+    }
+
+    // Brent's cycle detection over turn states: the guard is stuck in a
+    // loop iff the sequence of turns starting at the candidate's
+    // predecessor state never reaches kExitState.
+    [[nodiscard]] bool FindPath(const Candidate &candidate) const
+    {
+        const int obstacle_row = static_cast<int>(candidate.cell / cols_);
+        const int obstacle_col = static_cast<int>(candidate.cell % cols_);
+
+        State tortoise = candidate.predecessor;
+        State hare = NextTurn(tortoise, obstacle_row, obstacle_col);
+        std::size_t power = 1;
+        std::size_t length = 1;
+
+        while (hare != tortoise)
+        {
+            if (hare == kExitState)
+            {
+                return false;
+            }
+            if (power == length)
+            {
+                tortoise = hare;
+                power *= 2;
+                length = 0;
+            }
+            hare = NextTurn(hare, obstacle_row, obstacle_col);
+            ++length;
+        }
+
+        return true;
+    }
+
+    [[nodiscard]] static bool HitsObstacle(int row, int col, int dir,
+                                           int obstacle_row, int obstacle_col,
+                                           std::uint32_t target, int target_row, int target_col)
+    {
+        const int delta_row = kDeltaRow[dir];
+        const int delta_col = kDeltaCol[dir];
+
+        if (delta_row != 0 ? obstacle_col != col : obstacle_row != row)
+        {
+            return false;
+        }
+
+        const int obstacle_dist = (obstacle_row - row) * delta_row + (obstacle_col - col) * delta_col;
+        if (obstacle_dist <= 0)
+        {
+            return false;
+        }
+        if (target == kExit)
+        {
+            return true;
+        }
 
-        return std::set<QueueItem>{};
+        const int target_dist = (target_row - row) * delta_row + (target_col - col) * delta_col;
+        return obstacle_dist <= target_dist;
     }
 };
 
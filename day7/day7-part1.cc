@@ -8,95 +8,18 @@
  * @date 07.12.2024
  */
 
-#include <cassert>
+#include <chrono>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <ranges>
-#include <sstream>
 #include <stdexcept>
 #include <string>
-#include <utility>
 #include <vector>
-#include <functional>
 
-using Target = long long;
-using Numbers = std::vector<long long>;
-using Operators = std::vector<char>;
+#include "operator_search.h"
 
-std::pair<Target, Numbers> ParseLine(const std::string &line)
-{
-    auto colon_pos = line.find(':');
-    if (colon_pos == std::string::npos)
-    {
-        throw std::runtime_error("Invalid line format: Missing ':'");
-    }
-
-    Target target = std::stoll(line.substr(0, colon_pos));
-    Numbers numbers;
-
-    std::istringstream number_stream(line.substr(colon_pos + 1));
-    long long number;
-    while (number_stream >> number)
-    {
-        numbers.push_back(number);
-    }
-
-    return {target, numbers};
-}
-
-void GenerateOperatorCombinations(size_t num_slots, const std::function<void(const Operators &)> &callback)
-{
-    size_t num_combinations = 1 << num_slots; // 2^n combinations
-    for (size_t mask = 0; mask < num_combinations; ++mask)
-    {
-        Operators ops;
-        for (size_t i = 0; i < num_slots; ++i)
-        {
-            ops.push_back((mask & (1 << i)) ? '*' : '+');
-        }
-        callback(ops);
-    }
-}
-
-long long EvaluateExpression(const Numbers &numbers, const Operators &operators)
-{
-    assert(numbers.size() == operators.size() + 1);
-    long long result = numbers[0];
-
-    for (size_t i = 0; i < operators.size(); ++i)
-    {
-        switch (operators[i])
-        {
-        case '+':
-            result += numbers[i + 1];
-            break;
-        case '*':
-            result *= numbers[i + 1];
-            break;
-        default:
-            throw std::logic_error("Invalid operator");
-        }
-    }
-
-    return result;
-}
-
-bool MatchesTarget(Target target, const Numbers &numbers)
-{
-    size_t num_slots = numbers.size() - 1;
-    bool found = false;
-
-    GenerateOperatorCombinations(num_slots, [&](const Operators &ops)
-                                 {
-        if (EvaluateExpression(numbers, ops) == target)
-        {
-            found = true;
-        } });
-
-    return found;
-}
-
-long long ComputeCalibrationSum(const std::string &filename)
+std::uint64_t ComputeCalibrationSum(const std::string &filename)
 {
     std::ifstream input_file(filename);
     if (!input_file.is_open())
@@ -104,7 +27,7 @@ long long ComputeCalibrationSum(const std::string &filename)
         throw std::runtime_error("Unable to open input file");
     }
 
-    long long total_sum = 0;
+    std::vector<Equation> equations;
     std::string line;
 
     while (std::getline(input_file, line))
@@ -116,11 +39,7 @@ long long ComputeCalibrationSum(const std::string &filename)
 
         try
         {
-            auto [target, numbers] = ParseLine(line);
-            if (MatchesTarget(target, numbers))
-            {
-                total_sum += target;
-            }
+            equations.push_back(ParseEquation(line));
         }
         catch (const std::exception &e)
         {
@@ -128,7 +47,7 @@ long long ComputeCalibrationSum(const std::string &filename)
         }
     }
 
-    return total_sum;
+    return CalibrationDriver<MultiplyOperator, AddOperator>().SumSolvable(equations);
 }
 
 int main()
@@ -137,8 +56,15 @@ int main()
 
     try
     {
-        long long calibration_result = ComputeCalibrationSum(kInputFile);
+        auto start_time = std::chrono::high_resolution_clock::now();
+
+        std::uint64_t calibration_result = ComputeCalibrationSum(kInputFile);
+
+        auto end_time = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> elapsed_time = end_time - start_time;
+
         std::cout << "Total Calibration Result: " << calibration_result << '\n';
+        std::cout << "Execution time: " << elapsed_time.count() << " seconds\n";
     }
     catch (const std::exception &e)
     {
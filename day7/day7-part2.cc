@@ -8,11 +8,14 @@
  * @date 07.12.2024
  */
 
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
-#include <sstream>
+#include <stdexcept>
+
+#include "operator_search.h"
 
 class EquationSolver
 {
@@ -34,101 +37,15 @@ public:
 
     uint64_t SolvePartTwo() const
     {
-        uint64_t sum = 0;
-        for (const auto &eq : equations_)
-        {
-            if (CanSolveEquation(eq))
-            {
-                sum += eq.target;
-            }
-        }
-        return sum;
+        return CalibrationDriver<ConcatOperator, MultiplyOperator, AddOperator>().SumSolvable(equations_);
     }
 
 private:
-    struct Equation
-    {
-        uint64_t target;
-        std::vector<uint64_t> numbers;
-    };
     std::vector<Equation> equations_;
 
     void ParseLine(const std::string &line)
     {
-        std::istringstream iss(line);
-        Equation eq;
-        std::string temp;
-
-        std::getline(iss, temp, ':');
-        eq.target = std::stoull(temp);
-
-        uint64_t num;
-        while (iss >> num)
-        {
-            eq.numbers.push_back(num);
-        }
-
-        equations_.push_back(eq);
-    }
-
-    bool CanSolveEquation(const Equation &eq) const
-    {
-        return TryAllOperatorCombinations(eq.numbers, eq.target);
-    }
-
-    uint64_t ApplyOperator(uint64_t left, uint64_t right, int op) const
-    {
-        switch (op)
-        {
-        case 0:
-            return left + right;
-        case 1:
-            return left * right;
-        case 2:
-            return std::stoull(std::to_string(left) + std::to_string(right));
-        default:
-            throw std::runtime_error("Invalid operator");
-        }
-    }
-
-    bool TryAllOperatorCombinations(const std::vector<uint64_t> &numbers,
-                                    uint64_t target) const
-    {
-        if (numbers.empty())
-            return false;
-        if (numbers.size() == 1)
-            return numbers[0] == target;
-
-        int num_ops = numbers.size() - 1;
-        int max_combinations = 1;
-        for (int i = 0; i < num_ops; ++i)
-        {
-            max_combinations *= 3;
-        }
-
-        for (int combination = 0; combination < max_combinations; ++combination)
-        {
-            std::vector<int> operators;
-            int temp = combination;
-            for (int i = 0; i < num_ops; ++i)
-            {
-                operators.push_back(temp % 3);
-                temp /= 3;
-            }
-
-            uint64_t result = numbers[0];
-            for (size_t i = 0; i < operators.size(); ++i)
-            {
-                result = ApplyOperator(result, numbers[i + 1], operators[i]);
-            }
-
-            if (result == target)
-            {
-                return true;
-            }
-        }
-
-        return false;
+        equations_.push_back(ParseEquation(line));
     }
 };
 
@@ -136,9 +53,16 @@ int main()
 {
     try
     {
+        auto start_time = std::chrono::high_resolution_clock::now();
+
         EquationSolver solver("input.txt");
         uint64_t result = solver.SolvePartTwo();
+
+        auto end_time = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> elapsed_time = end_time - start_time;
+
         std::cout << "Part 2 result: " << result << std::endl;
+        std::cout << "Execution time: " << elapsed_time.count() << " seconds\n";
         return 0;
     }
     catch (const std::exception &e)
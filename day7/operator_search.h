@@ -0,0 +1,671 @@
+/**
+ * @file operator_search.h
+ * @brief Operator search shared by both parts of Advent of Code 2024 Day 7
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @author Volker Schwaberow <volker@schwaberow.de>
+ * @date 07.12.2024
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Outcome of undoing `left op operand == target` for the unknown left side.
+enum class UndoResult
+{
+    kBlocked,  // no left side produces the target
+    kReduced,  // exactly one left side does, stored in `left`
+    kAnyLeft   // every left side does, so the equation is solvable
+};
+
+class DecimalDigits
+{
+public:
+    // 10^digits(value), or 0 when that does not fit into 64 bits.
+    [[nodiscard]] static std::uint64_t Scale(std::uint64_t value)
+    {
+        const int digits = value == 0 ? 1 : Count(value);
+        return digits < static_cast<int>(kPowersOfTen.size()) ? kPowersOfTen[digits] : 0;
+    }
+
+private:
+    static constexpr std::array<std::uint64_t, 20> kPowersOfTen = []
+    {
+        std::array<std::uint64_t, 20> powers{};
+        std::uint64_t power = 1;
+        for (auto &entry : powers)
+        {
+            entry = power;
+            power *= 10;
+        }
+        return powers;
+    }();
+
+    [[nodiscard]] static int Count(std::uint64_t value)
+    {
+        // bit_width * log10(2) approximates the digit count to within one.
+        const int guess = static_cast<int>((std::bit_width(value) * 1233) >> 12);
+        return guess + (value >= kPowersOfTen[guess] ? 1 : 0);
+    }
+};
+
+// Each operator knows how to evaluate itself forwards and how to undo
+// itself against a target. `scale` is DecimalDigits::Scale(operand).
+// Apply returns false when the result is not a valid value, including when
+// it does not fit into 64 bits; such branches are pruned instead of being
+// allowed to wrap around into a false match. kNeverDecreases marks
+// operators whose result is never below `left` for a non-zero operand.
+
+struct AddOperator
+{
+    static constexpr bool kNeverDecreases = true;
+
+    static bool Apply(std::uint64_t left, std::uint64_t right, std::uint64_t scale, std::uint64_t &result)
+    {
+        (void)scale;
+        return !__builtin_add_overflow(left, right, &result);
+    }
+
+    // left + operand == target iff the difference is non-negative.
+    static UndoResult Undo(std::uint64_t target, std::uint64_t operand, std::uint64_t scale,
+                           std::uint64_t &left)
+    {
+        (void)scale;
+        left = target - operand;
+        return target >= operand ? UndoResult::kReduced : UndoResult::kBlocked;
+    }
+};
+
+struct MultiplyOperator
+{
+    static constexpr bool kNeverDecreases = true;
+
+    static bool Apply(std::uint64_t left, std::uint64_t right, std::uint64_t scale, std::uint64_t &result)
+    {
+        (void)scale;
+        return !__builtin_mul_overflow(left, right, &result);
+    }
+
+    // left * operand == target iff operand divides target exactly; left * 0
+    // is 0 whatever left is.
+    static UndoResult Undo(std::uint64_t target, std::uint64_t operand, std::uint64_t scale,
+                           std::uint64_t &left)
+    {
+        (void)scale;
+        if (operand == 0)
+        {
+            return target == 0 ? UndoResult::kAnyLeft : UndoResult::kBlocked;
+        }
+        left = target / operand;
+        return target % operand == 0 ? UndoResult::kReduced : UndoResult::kBlocked;
+    }
+};
+
+struct ConcatOperator
+{
+    static constexpr bool kNeverDecreases = true;
+
+    // left || right computed arithmetically as left * 10^digits(right) + right.
+    static bool Apply(std::uint64_t left, std::uint64_t right, std::uint64_t scale, std::uint64_t &result)
+    {
+        if (scale == 0)
+        {
+            result = right;
+            return left == 0;
+        }
+        std::uint64_t shifted = 0;
+        return !__builtin_mul_overflow(left, scale, &shifted) &&
+               !__builtin_add_overflow(shifted, right, &result);
+    }
+
+    // left || operand == target iff target ends in operand's digits.
+    static UndoResult Undo(std::uint64_t target, std::uint64_t operand, std::uint64_t scale,
+                           std::uint64_t &left)
+    {
+        if (scale == 0)
+        {
+            // A 20-digit operand only fits if it is the whole target.
+            left = 0;
+            return target == operand ? UndoResult::kReduced : UndoResult::kBlocked;
+        }
+        left = target / scale;
+        return target % scale == operand ? UndoResult::kReduced : UndoResult::kBlocked;
+    }
+};
+
+struct SubtractOperator
+{
+    static constexpr bool kNeverDecreases = false;
+
+    // Only defined while the result stays non-negative.
+    static bool Apply(std::uint64_t left, std::uint64_t right, std::uint64_t scale, std::uint64_t &result)
+    {
+        (void)scale;
+        return !__builtin_sub_overflow(left, right, &result);
+    }
+
+    static UndoResult Undo(std::uint64_t target, std::uint64_t operand, std::uint64_t scale,
+                           std::uint64_t &left)
+    {
+        (void)scale;
+        return __builtin_add_overflow(target, operand, &left) ? UndoResult::kBlocked
+                                                              : UndoResult::kReduced;
+    }
+};
+
+struct XorOperator
+{
+    static constexpr bool kNeverDecreases = false;
+
+    static bool Apply(std::uint64_t left, std::uint64_t right, std::uint64_t scale, std::uint64_t &result)
+    {
+        (void)scale;
+        result = left ^ right;
+        return true;
+    }
+
+    // XOR is its own inverse, so it never prunes.
+    static UndoResult Undo(std::uint64_t target, std::uint64_t operand, std::uint64_t scale,
+                           std::uint64_t &left)
+    {
+        (void)scale;
+        left = target ^ operand;
+        return UndoResult::kReduced;
+    }
+};
+
+// Decides whether the operands can be joined left to right with the given
+// operators so that they evaluate to the target. The operator set is a
+// template parameter, so every set gets its own kernel with the operators'
+// Undo rules inlined; they are tried in the order listed, so the most
+// selective operator should come first.
+//
+// The search runs backwards: the last operator is undone against the
+// target, which leaves a new target for the remaining operands. Operators
+// can often not be undone against a given target, so most branches die
+// after one or two levels instead of being evaluated to the end.
+//
+// When no operator can shrink a value and no operand is zero, everything
+// numbers[start..i] can produce is at least `head`, so a reduced target
+// below it is pruned as well.
+//
+// The depth-first walk keeps one frame per operand in a stack that is reused
+// across calls, so sibling branches start from their parent's reduced
+// target and a warmed-up search does not allocate.
+template <typename... Operators>
+class OperatorSearch
+{
+public:
+    static constexpr std::size_t kOperatorCount = sizeof...(Operators);
+    static constexpr bool kNeverDecreases = (Operators::kNeverDecreases && ...);
+
+    [[nodiscard]] bool CanReach(std::uint64_t target, const std::vector<std::uint64_t> &numbers)
+    {
+        return !numbers.empty() && CanReach(target, numbers, 0, numbers[0]);
+    }
+
+    // Same as above, but the operators between numbers[0..start] are already
+    // fixed and evaluated to `head`, which takes the place of numbers[start].
+    [[nodiscard]] bool CanReach(std::uint64_t target, const std::vector<std::uint64_t> &numbers,
+                                std::size_t start, std::uint64_t head)
+    {
+        const std::size_t count = numbers.size();
+
+        bool prune_below_head = kNeverDecreases;
+        scales_.resize(count);
+        for (std::size_t i = start + 1; i < count; ++i)
+        {
+            scales_[i] = DecimalDigits::Scale(numbers[i]);
+            prune_below_head = prune_below_head && numbers[i] != 0;
+        }
+
+        // stack_[i] holds the target numbers[start..i] must produce.
+        stack_.resize(count);
+        stack_[count - 1] = {target, 0};
+        std::size_t level = count - 1;
+
+        while (true)
+        {
+            Frame &frame = stack_[level];
+
+            if (level == start)
+            {
+                if (head == frame.target)
+                {
+                    return true;
+                }
+                if (++level == count)
+                {
+                    return false;
+                }
+                continue;
+            }
+
+            std::uint64_t reduced = 0;
+            UndoResult result = UndoResult::kBlocked;
+
+            while (result == UndoResult::kBlocked && frame.next_operator < kOperatorCount)
+            {
+                result = Undo(frame.next_operator++, frame.target, numbers[level], scales_[level],
+                              reduced, std::index_sequence_for<Operators...>{});
+                if (result == UndoResult::kReduced && prune_below_head && reduced < head)
+                {
+                    result = UndoResult::kBlocked;
+                }
+            }
+
+            if (result == UndoResult::kAnyLeft)
+            {
+                return true;
+            }
+            if (result == UndoResult::kReduced)
+            {
+                --level;
+                stack_[level] = {reduced, 0};
+            }
+            else if (++level == count)
+            {
+                return false;
+            }
+        }
+    }
+
+    // Meet-in-the-middle variant for equations too long to backtrack. The
+    // values the left half can produce are enumerated forwards, the values
+    // the left half would have to produce are enumerated backwards from the
+    // target by undoing the right half's operators, and the equation is
+    // solvable iff the two sets intersect.
+    [[nodiscard]] bool CanReachFromBothEnds(std::uint64_t target, const std::vector<std::uint64_t> &numbers)
+    {
+        const std::size_t count = numbers.size();
+        if (count < 2)
+        {
+            return CanReach(target, numbers);
+        }
+
+        const bool prune = kNeverDecreases && std::find(numbers.begin() + 1, numbers.end(), 0) == numbers.end();
+        const std::size_t middle = count / 2;
+
+        // Everything numbers[0..middle) can produce.
+        left_values_.assign(1, numbers[0]);
+        for (std::size_t i = 1; i < middle; ++i)
+        {
+            const std::uint64_t scale = DecimalDigits::Scale(numbers[i]);
+            next_values_.clear();
+            for (const std::uint64_t left : left_values_)
+            {
+                for (std::size_t op = 0; op < kOperatorCount; ++op)
+                {
+                    std::uint64_t value = 0;
+                    if (Apply(op, left, numbers[i], scale, value, std::index_sequence_for<Operators...>{}) &&
+                        !(prune && value > target))
+                    {
+                        next_values_.push_back(value);
+                    }
+                }
+            }
+            Deduplicate(next_values_);
+            std::swap(left_values_, next_values_);
+        }
+
+        // Everything numbers[0..middle) would have to produce.
+        right_values_.assign(1, target);
+        for (std::size_t i = count - 1; i >= middle; --i)
+        {
+            const std::uint64_t scale = DecimalDigits::Scale(numbers[i]);
+            next_values_.clear();
+            for (const std::uint64_t needed : right_values_)
+            {
+                for (std::size_t op = 0; op < kOperatorCount; ++op)
+                {
+                    std::uint64_t reduced = 0;
+                    switch (Undo(op, needed, numbers[i], scale, reduced, std::index_sequence_for<Operators...>{}))
+                    {
+                    case UndoResult::kAnyLeft:
+                        return true;
+                    case UndoResult::kReduced:
+                        if (!(prune && reduced < numbers[0]))
+                        {
+                            next_values_.push_back(reduced);
+                        }
+                        break;
+                    case UndoResult::kBlocked:
+                        break;
+                    }
+                }
+            }
+            Deduplicate(next_values_);
+            std::swap(right_values_, next_values_);
+        }
+
+        const std::unordered_set<std::uint64_t> reachable(left_values_.begin(), left_values_.end());
+        return std::ranges::any_of(right_values_, [&](std::uint64_t value)
+                                   { return reachable.contains(value); });
+    }
+
+    // Evaluates `left op right` forwards for the op-th operator of the set.
+    [[nodiscard]] static bool Apply(std::size_t op, std::uint64_t left, std::uint64_t right,
+                                    std::uint64_t &result)
+    {
+        return Apply(op, left, right, DecimalDigits::Scale(right), result,
+                     std::index_sequence_for<Operators...>{});
+    }
+
+private:
+    using OperatorTuple = std::tuple<Operators...>;
+
+    struct Frame
+    {
+        std::uint64_t target;
+        std::uint8_t next_operator;
+    };
+
+    std::vector<Frame> stack_;
+    std::vector<std::uint64_t> scales_;
+    std::vector<std::uint64_t> left_values_;
+    std::vector<std::uint64_t> right_values_;
+    std::vector<std::uint64_t> next_values_;
+
+    static void Deduplicate(std::vector<std::uint64_t> &values)
+    {
+        std::ranges::sort(values);
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+    }
+
+    template <std::size_t... I>
+    [[nodiscard]] static UndoResult Undo(std::size_t op, std::uint64_t target, std::uint64_t operand,
+                                         std::uint64_t scale, std::uint64_t &left,
+                                         std::index_sequence<I...>)
+    {
+        UndoResult result = UndoResult::kBlocked;
+        (void)((op == I && (result = std::tuple_element_t<I, OperatorTuple>::Undo(target, operand, scale, left),
+                            true)) ||
+               ...);
+        return result;
+    }
+
+    template <std::size_t... I>
+    [[nodiscard]] static bool Apply(std::size_t op, std::uint64_t left, std::uint64_t right,
+                                    std::uint64_t scale, std::uint64_t &result, std::index_sequence<I...>)
+    {
+        bool valid = false;
+        (void)((op == I && (valid = std::tuple_element_t<I, OperatorTuple>::Apply(left, right, scale, result),
+                            true)) ||
+               ...);
+        return valid;
+    }
+};
+
+struct Equation
+{
+    std::uint64_t target;
+    std::vector<std::uint64_t> numbers;
+};
+
+// Parses one unsigned decimal number. Unlike operator>> and std::stoull,
+// a leading '-' is rejected instead of wrapping around.
+inline std::uint64_t ParseNumber(std::string_view token)
+{
+    std::uint64_t value = 0;
+    const auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), value);
+    if (error == std::errc::result_out_of_range)
+    {
+        throw std::out_of_range("Number does not fit into 64 bits: " + std::string(token));
+    }
+    if (error != std::errc() || end != token.data() + token.size())
+    {
+        throw std::invalid_argument("Malformed number: " + std::string(token));
+    }
+    return value;
+}
+
+// Parses "<target>: <operand> <operand> ...".
+inline Equation ParseEquation(std::string_view line)
+{
+    const std::size_t colon = line.find(':');
+    if (colon == std::string_view::npos)
+    {
+        throw std::invalid_argument("Invalid line format: Missing ':'");
+    }
+
+    auto Trim = [](std::string_view text)
+    {
+        const std::size_t first = text.find_first_not_of(" \t\r");
+        if (first == std::string_view::npos)
+        {
+            return std::string_view();
+        }
+        return text.substr(first, text.find_last_not_of(" \t\r") - first + 1);
+    };
+
+    Equation equation{ParseNumber(Trim(line.substr(0, colon))), {}};
+    std::string_view operands = line.substr(colon + 1);
+    while (!(operands = Trim(operands)).empty())
+    {
+        const std::size_t token_end = std::min(operands.find_first_of(" \t\r"), operands.size());
+        equation.numbers.push_back(ParseNumber(operands.substr(0, token_end)));
+        operands.remove_prefix(token_end);
+    }
+    return equation;
+}
+
+enum class SearchStrategy
+{
+    kBacktracking,
+    kMeetInTheMiddle
+};
+
+struct EquationOutcome
+{
+    bool solvable;
+    SearchStrategy strategy;
+};
+
+// Sums the targets of all solvable equations on a pool of worker threads,
+// using one OperatorSearch<Operators...> per worker.
+//
+// The cost of an equation grows exponentially with its operand count, so
+// work is handed out longest-first and idle workers steal from busy ones.
+// Equations with many operands are further split into one task per choice
+// of their first few operators, and equations with at least
+// `meet_in_the_middle_operands` operands are solved from both ends instead.
+// Solved flags are kept per equation and summed in input order, so the
+// result does not depend on scheduling.
+template <typename... Operators>
+class CalibrationDriver
+{
+public:
+    static constexpr std::size_t kDefaultMeetInTheMiddleOperands = 20;
+
+    explicit CalibrationDriver(unsigned thread_count = std::thread::hardware_concurrency(),
+                               std::size_t meet_in_the_middle_operands = kDefaultMeetInTheMiddleOperands)
+        : thread_count_(std::max(thread_count, 1u)),
+          meet_in_the_middle_operands_(meet_in_the_middle_operands) {}
+
+    // Throws std::out_of_range if the sum of solvable targets overflows.
+    [[nodiscard]] std::uint64_t SumSolvable(const std::vector<Equation> &equations) const
+    {
+        const std::vector<EquationOutcome> outcomes = Solve(equations);
+
+        std::uint64_t sum = 0;
+        for (std::size_t i = 0; i < equations.size(); ++i)
+        {
+            if (outcomes[i].solvable && __builtin_add_overflow(sum, equations[i].target, &sum))
+            {
+                throw std::out_of_range("Calibration sum does not fit into 64 bits");
+            }
+        }
+        return sum;
+    }
+
+    // Solvability of every equation along with the strategy used for it.
+    [[nodiscard]] std::vector<EquationOutcome> Solve(const std::vector<Equation> &equations) const
+    {
+        std::vector<Task> tasks = MakeTasks(equations);
+        std::ranges::stable_sort(tasks, std::greater<>{}, &Task::remaining);
+
+        std::vector<WorkQueue> queues(thread_count_);
+        for (std::size_t i = 0; i < tasks.size(); ++i)
+        {
+            queues[i % thread_count_].tasks.push_back(tasks[i]);
+        }
+
+        std::unique_ptr<std::atomic<bool>[]> solved(new std::atomic<bool>[equations.size()]{});
+
+        auto worker = [&](unsigned id)
+        {
+            Search search;
+            Task task;
+            while (Take(queues, id, task))
+            {
+                if (solved[task.equation].load(std::memory_order_relaxed))
+                {
+                    continue;
+                }
+
+                const Equation &eq = equations[task.equation];
+                const bool solvable = Strategy(eq) == SearchStrategy::kMeetInTheMiddle
+                                          ? search.CanReachFromBothEnds(eq.target, eq.numbers)
+                                          : search.CanReach(eq.target, eq.numbers, task.start, task.head);
+                if (solvable)
+                {
+                    solved[task.equation].store(true, std::memory_order_relaxed);
+                }
+            }
+        };
+
+        {
+            std::vector<std::jthread> threads;
+            for (unsigned id = 1; id < thread_count_; ++id)
+            {
+                threads.emplace_back(worker, id);
+            }
+            worker(0);
+        }
+
+        std::vector<EquationOutcome> outcomes;
+        outcomes.reserve(equations.size());
+        for (std::size_t i = 0; i < equations.size(); ++i)
+        {
+            outcomes.push_back({solved[i].load(std::memory_order_relaxed), Strategy(equations[i])});
+        }
+        return outcomes;
+    }
+
+private:
+    using Search = OperatorSearch<Operators...>;
+
+    static constexpr std::size_t kSplitMinOperands = 12;
+    static constexpr std::size_t kSplitOperators = 3;
+
+    struct Task
+    {
+        std::uint32_t equation;
+        std::uint32_t start;
+        std::uint32_t remaining;
+        std::uint64_t head;
+    };
+
+    struct alignas(64) WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    unsigned thread_count_;
+    std::size_t meet_in_the_middle_operands_;
+
+    [[nodiscard]] SearchStrategy Strategy(const Equation &eq) const
+    {
+        return eq.numbers.size() >= meet_in_the_middle_operands_ ? SearchStrategy::kMeetInTheMiddle
+                                                                 : SearchStrategy::kBacktracking;
+    }
+
+    [[nodiscard]] std::vector<Task> MakeTasks(const std::vector<Equation> &equations) const
+    {
+        std::vector<Task> tasks;
+        std::vector<std::uint64_t> heads;
+        std::vector<std::uint64_t> next_heads;
+
+        for (std::uint32_t i = 0; i < equations.size(); ++i)
+        {
+            const auto &numbers = equations[i].numbers;
+            if (numbers.empty())
+            {
+                continue;
+            }
+
+            const bool split = numbers.size() >= kSplitMinOperands &&
+                               Strategy(equations[i]) == SearchStrategy::kBacktracking;
+            const std::size_t start = split ? kSplitOperators : 0;
+            const bool prune_above_target =
+                Search::kNeverDecreases && std::ranges::find(numbers, 0) == numbers.end();
+            heads.assign(1, numbers[0]);
+            for (std::size_t j = 1; j <= start; ++j)
+            {
+                next_heads.clear();
+                for (const std::uint64_t head : heads)
+                {
+                    for (std::size_t op = 0; op < Search::kOperatorCount; ++op)
+                    {
+                        std::uint64_t value = 0;
+                        if (Search::Apply(op, head, numbers[j], value) &&
+                            !(prune_above_target && value > equations[i].target))
+                        {
+                            next_heads.push_back(value);
+                        }
+                    }
+                }
+                std::swap(heads, next_heads);
+            }
+
+            const auto remaining = static_cast<std::uint32_t>(numbers.size() - start);
+            for (const std::uint64_t head : heads)
+            {
+                tasks.push_back({i, static_cast<std::uint32_t>(start), remaining, head});
+            }
+        }
+
+        return tasks;
+    }
+
+    // Pops from the worker's own queue, or steals the largest task left in
+    // any other queue once its own runs dry. No tasks are created while the
+    // pool runs, so finding every queue empty means the work is done.
+    static bool Take(std::vector<WorkQueue> &queues, unsigned id, Task &task)
+    {
+        for (std::size_t offset = 0; offset < queues.size(); ++offset)
+        {
+            WorkQueue &queue = queues[(id + offset) % queues.size()];
+            std::lock_guard lock(queue.mutex);
+            if (!queue.tasks.empty())
+            {
+                task = queue.tasks.front();
+                queue.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+};
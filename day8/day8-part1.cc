@@ -9,23 +9,44 @@
  */
 
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
 #include <iostream>
-#include <map>
-#include <set>
 #include <string>
 #include <utility>
 #include <vector>
 #include <fstream>
 
+#include "sparse_antennas.h"
+
 using Position = std::pair<int, int>;
 
-struct PositionComparator
+class AntinodeGrid
 {
-    bool operator()(const Position &lhs, const Position &rhs) const
+public:
+    AntinodeGrid(int width, int height)
+        : width_(width), bits_((static_cast<std::size_t>(width) * height + 63) / 64, 0) {}
+
+    void Mark(int x, int y)
+    {
+        const std::size_t index = static_cast<std::size_t>(y) * width_ + x;
+        bits_[index / 64] |= std::uint64_t{1} << (index % 64);
+    }
+
+    [[nodiscard]] std::size_t Count() const
     {
-        return lhs.first == rhs.first ? lhs.second < rhs.second
-                                      : lhs.first < rhs.first;
+        std::size_t count = 0;
+        for (const std::uint64_t word : bits_)
+        {
+            count += std::popcount(word);
+        }
+        return count;
     }
+
+private:
+    int width_;
+    std::vector<std::uint64_t> bits_;
 };
 
 int main()
@@ -39,6 +60,15 @@ int main()
         std::cerr << "Failed to open input file." << std::endl;
         return 1;
     }
+    if (std::getline(input_file, line) && IsSparseHeader(line))
+    {
+        std::cout << CountSparseAntinodes(ParseSparseMap(line, input_file)) << std::endl;
+        return 0;
+    }
+    if (!line.empty())
+    {
+        grid.push_back(line);
+    }
     while (std::getline(input_file, line))
     {
         if (!line.empty())
@@ -51,22 +81,22 @@ int main()
     const int height = grid.size();
     const int width = grid.empty() ? 0 : grid[0].size();
 
-    std::map<char, std::vector<Position>> antennas;
+    std::array<std::vector<Position>, 128> antennas;
 
     for (int y = 0; y < height; ++y)
     {
         const auto &row = grid[y];
         for (int x = 0; x < width; ++x)
         {
-            char cell = row[x];
-            if (cell != '.')
+            const auto cell = static_cast<unsigned char>(row[x]);
+            if (cell != '.' && cell < antennas.size())
             {
                 antennas[cell].emplace_back(x, y);
             }
         }
     }
 
-    std::set<Position, PositionComparator> antinodes;
+    AntinodeGrid antinodes(width, height);
 
     auto is_within_bounds = [width, height](const Position &pos)
     {
@@ -74,7 +104,7 @@ int main()
                pos.second < height;
     };
 
-    for (const auto &[freq, positions] : antennas)
+    for (const auto &positions : antennas)
     {
         const auto &antenna_positions = positions;
         const int n = antenna_positions.size();
@@ -91,17 +121,17 @@ int main()
 
                 if (is_within_bounds(C1))
                 {
-                    antinodes.insert(C1);
+                    antinodes.Mark(C1.first, C1.second);
                 }
                 if (is_within_bounds(C2))
                 {
-                    antinodes.insert(C2);
+                    antinodes.Mark(C2.first, C2.second);
                 }
             }
         }
     }
 
-    std::cout << antinodes.size() << std::endl;
+    std::cout << antinodes.Count() << std::endl;
 
     return 0;
 }
\ No newline at end of file
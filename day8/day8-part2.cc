@@ -9,25 +9,166 @@
  */
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <cassert>
+#include <cctype>
 #include <charconv>
+#include <cstdint>
 #include <functional>
 #include <iostream>
 #include <memory>
 #include <numeric>
-#include <set>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <vector>
-#include <map>
 #include <fstream>
 
+#include "sparse_antennas.h"
+
+struct Position
+{
+    int x;
+    int y;
+};
+
+class AntinodeGrid
+{
+public:
+    AntinodeGrid(int width, int height)
+        : width_(width), bits_((static_cast<std::size_t>(width) * height + 63) / 64, 0) {}
+
+    void Mark(int x, int y)
+    {
+        const std::size_t index = static_cast<std::size_t>(y) * width_ + x;
+        bits_[index / 64] |= std::uint64_t{1} << (index % 64);
+    }
+
+    // Mark for a grid that several threads write to at once.
+    void MarkShared(int x, int y)
+    {
+        const std::size_t index = static_cast<std::size_t>(y) * width_ + x;
+        std::atomic_ref<std::uint64_t>(bits_[index / 64]).fetch_or(std::uint64_t{1} << (index % 64), std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] std::size_t Bytes() const
+    {
+        return bits_.size() * sizeof(std::uint64_t);
+    }
+
+    [[nodiscard]] std::size_t Count() const
+    {
+        std::size_t count = 0;
+        for (const std::uint64_t word : bits_)
+        {
+            count += std::popcount(word);
+        }
+        return count;
+    }
+
+    // Size of the union of all shards. Each thread ORs and counts its own
+    // slice of words across every shard.
+    [[nodiscard]] static std::size_t CountUnion(const std::vector<AntinodeGrid> &shards,
+                                                unsigned thread_count)
+    {
+        const std::size_t words = shards.front().bits_.size();
+        std::vector<std::size_t> counts(thread_count, 0);
+
+        RunOnThreads(thread_count, [&](unsigned id)
+                     {
+            const std::size_t begin = words * id / thread_count;
+            const std::size_t end = words * (id + 1) / thread_count;
+            std::size_t count = 0;
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                std::uint64_t word = 0;
+                for (const auto &shard : shards)
+                {
+                    word |= shard.bits_[i];
+                }
+                count += std::popcount(word);
+            }
+            counts[id] = count; });
+
+        return std::accumulate(counts.begin(), counts.end(), std::size_t{0});
+    }
+
+    template <typename Worker>
+    static void RunOnThreads(unsigned thread_count, Worker worker)
+    {
+        std::vector<std::jthread> threads;
+        for (unsigned id = 1; id < thread_count; ++id)
+        {
+            threads.emplace_back(worker, id);
+        }
+        worker(0);
+    }
+
+private:
+    int width_;
+    std::vector<std::uint64_t> bits_;
+};
+
+// A run of antenna pairs (i, j > i) of one frequency with i in
+// [first_begin, first_end).
+struct PairBlock
+{
+    unsigned char frequency;
+    std::size_t first_begin;
+    std::size_t first_end;
+};
+
+// Splits every frequency into blocks of roughly kPairsPerBlock pairs, so a
+// few very dense frequencies spread over all threads just like many sparse
+// ones do.
+std::vector<PairBlock> MakePairBlocks(const std::array<std::vector<Position>, 128> &frequency_to_positions)
+{
+    constexpr std::size_t kPairsPerBlock = 4096;
+    std::vector<PairBlock> blocks;
+
+    for (std::size_t frequency = 0; frequency < frequency_to_positions.size(); ++frequency)
+    {
+        const std::size_t n = frequency_to_positions[frequency].size();
+        std::size_t begin = 0;
+        std::size_t pairs = 0;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            pairs += n - 1 - i;
+            if (pairs >= kPairsPerBlock || i + 1 == n)
+            {
+                if (pairs > 0)
+                {
+                    blocks.push_back({static_cast<unsigned char>(frequency), begin, i + 1});
+                }
+                begin = i + 1;
+                pairs = 0;
+            }
+        }
+    }
+
+    return blocks;
+}
+
+// Memory the per-thread antinode grids may take together.
+constexpr std::size_t kShardBudgetBytes = std::size_t{256} << 20;
+
 int main()
 {
     std::vector<std::string> grid;
     {
         std::ifstream input_file("input.txt");
         std::string line;
+        if (std::getline(input_file, line) && IsSparseHeader(line))
+        {
+            std::cout << SparseHarmonicCounter(ParseSparseMap(line, input_file)).Count() << std::endl;
+            return 0;
+        }
+        if (!line.empty())
+        {
+            grid.push_back(std::move(line));
+        }
         while (std::getline(input_file, line))
         {
             if (!line.empty())
@@ -40,79 +181,92 @@ int main()
     const int height = grid.size();
     const int width = grid.empty() ? 0 : grid[0].size();
 
-    struct Position
-    {
-        int x;
-        int y;
-
-        auto operator<=>(const Position &) const = default;
-    };
-
-    std::map<char, std::vector<Position>> frequency_to_positions;
+    std::array<std::vector<Position>, 128> frequency_to_positions;
 
     for (int y = 0; y < height; ++y)
     {
         const auto &line = grid[y];
         for (int x = 0; x < width; ++x)
         {
-            char c = line[x];
-            if (std::isalnum(c))
+            const auto c = static_cast<unsigned char>(line[x]);
+            if (c < frequency_to_positions.size() && std::isalnum(c))
             {
                 frequency_to_positions[c].push_back({x, y});
             }
         }
     }
 
-    std::set<Position> antinode_positions;
+    // One private grid per thread while they fit into kShardBudgetBytes;
+    // beyond that, threads share the grids and mark with atomic fetch_or.
+    const unsigned thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+    const std::vector<PairBlock> blocks = MakePairBlocks(frequency_to_positions);
+    const std::size_t grid_bytes = std::max<std::size_t>(AntinodeGrid(width, 1).Bytes() * height, 1);
+    const unsigned shard_count = static_cast<unsigned>(
+        std::clamp<std::size_t>(kShardBudgetBytes / grid_bytes, 1, thread_count));
+    const bool shared = shard_count < thread_count;
+    std::vector<AntinodeGrid> shards(shard_count, AntinodeGrid(width, height));
+    std::atomic<std::size_t> next_block{0};
 
-    for (const auto &[frequency, positions] : frequency_to_positions)
-    {
-        if (positions.size() < 2)
+    AntinodeGrid::RunOnThreads(thread_count, [&](unsigned id)
+                               {
+        AntinodeGrid &antinode_positions = shards[id % shard_count];
+        auto Mark = [&](int x, int y)
         {
-            continue;
-        }
-
-        for (size_t i = 0; i < positions.size(); ++i)
+            if (shared)
+            {
+                antinode_positions.MarkShared(x, y);
+            }
+            else
+            {
+                antinode_positions.Mark(x, y);
+            }
+        };
+        for (std::size_t b = next_block++; b < blocks.size(); b = next_block++)
         {
-            for (size_t j = i + 1; j < positions.size(); ++j)
+            const PairBlock &block = blocks[b];
+            const auto &positions = frequency_to_positions[block.frequency];
+
+            for (size_t i = block.first_begin; i < block.first_end; ++i)
             {
-                const auto &pos1 = positions[i];
-                const auto &pos2 = positions[j];
+                for (size_t j = i + 1; j < positions.size(); ++j)
+                {
+                    const auto &pos1 = positions[i];
+                    const auto &pos2 = positions[j];
 
-                int dx = pos2.x - pos1.x;
-                int dy = pos2.y - pos1.y;
+                    int dx = pos2.x - pos1.x;
+                    int dy = pos2.y - pos1.y;
 
-                int gcd = std::gcd(dx, dy);
+                    int gcd = std::gcd(dx, dy);
 
-                int step_x = dx / gcd;
-                int step_y = dy / gcd;
+                    int step_x = dx / gcd;
+                    int step_y = dy / gcd;
 
-                auto add_positions = [&](int start_x, int start_y, int dir)
-                {
-                    int x = start_x;
-                    int y = start_y;
-                    while (true)
+                    auto add_positions = [&](int start_x, int start_y, int dir)
                     {
-                        x += dir * step_x;
-                        y += dir * step_y;
-                        if (x < 0 || x >= width || y < 0 || y >= height)
+                        int x = start_x;
+                        int y = start_y;
+                        while (true)
                         {
-                            break;
+                            x += dir * step_x;
+                            y += dir * step_y;
+                            if (x < 0 || x >= width || y < 0 || y >= height)
+                            {
+                                break;
+                            }
+                            Mark(x, y);
                         }
-                        antinode_positions.insert({x, y});
-                    }
-                };
+                    };
 
-                add_positions(pos1.x, pos1.y, 1);
-                add_positions(pos1.x, pos1.y, -1);
+                    add_positions(pos1.x, pos1.y, 1);
+                    add_positions(pos1.x, pos1.y, -1);
 
-                antinode_positions.insert(pos1);
-                antinode_positions.insert(pos2);
+                    Mark(pos1.x, pos1.y);
+                    Mark(pos2.x, pos2.y);
+                }
             }
-        }
-    }
+        } });
 
-    std::cout << antinode_positions.size() << std::endl;
+    std::cout << AntinodeGrid::CountUnion(shards, thread_count) << std::endl;
 
     return 0;
 }
@@ -0,0 +1,405 @@
+/**
+ * @file sparse_antennas.h
+ * @brief Sparse coordinate mode shared by both parts of Advent of Code 2024 Day 8
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @author Volker Schwaberow <volker@schwaberow.de>
+ * @date 09.12.2024
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Maps too large for a dense grid are given as a list of antennas instead:
+//
+//     sparse <width> <height>
+//     <frequency> <x> <y>
+//     ...
+//
+// Nothing below needs memory proportional to width * height. Part 1 stores
+// the antinodes it finds. Part 2 stores one line per antenna pair, so
+// O(n^2) for n antennas of one frequency. It also intersects every pair of
+// non-parallel lines, which is O(n^4) time and takes memory proportional to
+// the number of crossings. That is fine for a few hundred antennas per
+// frequency, but not for thousands.
+//
+// Width and height may be anything up to 2^32 - 1. Products of two
+// coordinates or steps are formed in 128 bits.
+
+// 128-bit intermediate for products of two coordinates.
+__extension__ typedef __int128 WideInt;
+
+struct SparseAntenna
+{
+    std::int64_t x;
+    std::int64_t y;
+};
+
+struct SparseAntennaMap
+{
+    std::int64_t width = 0;
+    std::int64_t height = 0;
+    std::unordered_map<char, std::vector<SparseAntenna>> frequencies;
+
+    [[nodiscard]] bool Contains(std::int64_t x, std::int64_t y) const
+    {
+        return x >= 0 && x < width && y >= 0 && y < height;
+    }
+};
+
+// True if the first line of the input announces the sparse format.
+inline bool IsSparseHeader(const std::string &line)
+{
+    return line.starts_with("sparse ");
+}
+
+// Reads the rest of a sparse map whose header line has already been read.
+inline SparseAntennaMap ParseSparseMap(const std::string &header, std::istream &input)
+{
+    SparseAntennaMap map;
+    std::istringstream header_stream(header.substr(std::string("sparse").size()));
+    if (!(header_stream >> map.width >> map.height) || map.width <= 0 || map.height <= 0 ||
+        map.width > UINT32_MAX || map.height > UINT32_MAX)
+    {
+        throw std::runtime_error("Invalid sparse header: " + header);
+    }
+
+    char frequency = 0;
+    SparseAntenna antenna{};
+    while (input >> frequency >> antenna.x >> antenna.y)
+    {
+        if (!map.Contains(antenna.x, antenna.y))
+        {
+            throw std::runtime_error("Antenna outside of the map");
+        }
+        map.frequencies[frequency].push_back(antenna);
+    }
+
+    return map;
+}
+
+// Linear-probing hash table from 64-bit keys to counters. One key value is
+// reserved to mark empty slots; it is never a valid packed coordinate.
+class OpenAddressingCounter
+{
+public:
+    // Adds one to the key's counter and returns the new count.
+    std::uint32_t Increment(std::uint64_t key)
+    {
+        if ((size_ + 1) * 2 > keys_.size())
+        {
+            Grow();
+        }
+
+        std::size_t slot = Slot(key);
+        while (keys_[slot] != kEmpty && keys_[slot] != key)
+        {
+            slot = (slot + 1) & (keys_.size() - 1);
+        }
+        if (keys_[slot] == kEmpty)
+        {
+            keys_[slot] = key;
+            ++size_;
+        }
+        return ++counts_[slot];
+    }
+
+    [[nodiscard]] std::size_t Size() const
+    {
+        return size_;
+    }
+
+    template <typename Visitor>
+    void ForEach(Visitor visitor) const
+    {
+        for (std::size_t slot = 0; slot < keys_.size(); ++slot)
+        {
+            if (keys_[slot] != kEmpty)
+            {
+                visitor(keys_[slot], counts_[slot]);
+            }
+        }
+    }
+
+private:
+    static constexpr std::uint64_t kEmpty = UINT64_MAX;
+
+    std::vector<std::uint64_t> keys_;
+    std::vector<std::uint32_t> counts_;
+    std::size_t size_ = 0;
+
+    [[nodiscard]] std::size_t Slot(std::uint64_t key) const
+    {
+        // splitmix64 finalizer.
+        key ^= key >> 30;
+        key *= 0xbf58476d1ce4e5b9ULL;
+        key ^= key >> 27;
+        key *= 0x94d049bb133111ebULL;
+        key ^= key >> 31;
+        return key & (keys_.size() - 1);
+    }
+
+    void Grow()
+    {
+        std::vector<std::uint64_t> old_keys(std::max<std::size_t>(keys_.size() * 2, 16), kEmpty);
+        std::vector<std::uint32_t> old_counts(old_keys.size(), 0);
+        std::swap(keys_, old_keys);
+        std::swap(counts_, old_counts);
+
+        for (std::size_t i = 0; i < old_keys.size(); ++i)
+        {
+            if (old_keys[i] != kEmpty)
+            {
+                std::size_t slot = Slot(old_keys[i]);
+                while (keys_[slot] != kEmpty)
+                {
+                    slot = (slot + 1) & (keys_.size() - 1);
+                }
+                keys_[slot] = old_keys[i];
+                counts_[slot] = old_counts[i];
+            }
+        }
+    }
+};
+
+inline std::uint64_t PackCoordinate(std::int64_t x, std::int64_t y)
+{
+    return (static_cast<std::uint64_t>(x) << 32) | static_cast<std::uint64_t>(y);
+}
+
+// Part 1: the two points mirroring each antenna pair, collected in a hash
+// set so that only antinodes that actually exist take up memory.
+inline std::size_t CountSparseAntinodes(const SparseAntennaMap &map)
+{
+    OpenAddressingCounter antinodes;
+
+    for (const auto &[frequency, antennas] : map.frequencies)
+    {
+        for (std::size_t i = 0; i < antennas.size(); ++i)
+        {
+            for (std::size_t j = i + 1; j < antennas.size(); ++j)
+            {
+                const SparseAntenna &a = antennas[i];
+                const SparseAntenna &b = antennas[j];
+                if (map.Contains(2 * a.x - b.x, 2 * a.y - b.y))
+                {
+                    antinodes.Increment(PackCoordinate(2 * a.x - b.x, 2 * a.y - b.y));
+                }
+                if (map.Contains(2 * b.x - a.x, 2 * b.y - a.y))
+                {
+                    antinodes.Increment(PackCoordinate(2 * b.x - a.x, 2 * b.y - a.y));
+                }
+            }
+        }
+    }
+
+    return antinodes.Size();
+}
+
+// Part 2 without enumerating any ray. Every antenna pair spans a full
+// line; the answer is the number of lattice points inside the map that lie
+// on at least one line. Each line's lattice points are counted in closed
+// form, and points shared by several lines are subtracted again
+// (inclusion-exclusion): two distinct lines share at most one point, so a
+// point where k lines meet is found as k*(k-1)/2 pairwise intersections
+// and has been counted k - 1 times too often.
+class SparseHarmonicCounter
+{
+public:
+    explicit SparseHarmonicCounter(SparseAntennaMap map) : map_(std::move(map))
+    {
+        CollectLines();
+    }
+
+    [[nodiscard]] std::uint64_t Count() const
+    {
+        std::uint64_t total = 0;
+        for (const Line &line : lines_)
+        {
+            total += LatticePointsInside(line);
+        }
+
+        // Lines are sorted by direction, so each line only needs to be
+        // intersected with the lines after its own group of parallels.
+        OpenAddressingCounter crossings;
+        const bool narrow = map_.width <= kNarrowExtent && map_.height <= kNarrowExtent;
+        std::size_t next_group = 0;
+        for (std::size_t i = 0; i < lines_.size(); ++i)
+        {
+            if (i == next_group)
+            {
+                while (next_group < lines_.size() && lines_[next_group].dx == lines_[i].dx &&
+                       lines_[next_group].dy == lines_[i].dy)
+                {
+                    ++next_group;
+                }
+            }
+            for (std::size_t j = next_group; j < lines_.size(); ++j)
+            {
+                std::int64_t x = 0;
+                std::int64_t y = 0;
+                const bool crosses = narrow ? Intersect<std::int64_t>(lines_[i], lines_[j], x, y)
+                                            : Intersect<WideInt>(lines_[i], lines_[j], x, y);
+                if (crosses)
+                {
+                    crossings.Increment(PackCoordinate(x, y));
+                }
+            }
+        }
+
+        crossings.ForEach([&](std::uint64_t, std::uint32_t pairs)
+                          {
+            // Solve k * (k - 1) / 2 == pairs for k.
+            std::uint64_t k = 2;
+            while (k * (k - 1) / 2 < pairs)
+            {
+                ++k;
+            }
+            total -= k - 1; });
+
+        return total;
+    }
+
+private:
+    // Points (x0, y0) + t * (dx, dy) with (dx, dy) primitive and pointing
+    // right (or straight down). dy * x - dx * y is the same `offset` for
+    // every point of the line, so equal lines have equal (dx, dy, offset).
+    struct Line
+    {
+        std::int64_t x0;
+        std::int64_t y0;
+        std::int64_t dx;
+        std::int64_t dy;
+        WideInt offset;
+
+        [[nodiscard]] auto Key() const
+        {
+            return std::tie(dx, dy, offset);
+        }
+    };
+
+    // Up to here, steps and coordinate differences stay below 2^30 and
+    // their products below 2^61.
+    static constexpr std::int64_t kNarrowExtent = std::int64_t{1} << 30;
+
+    SparseAntennaMap map_;
+    std::vector<Line> lines_;
+
+    void CollectLines()
+    {
+        for (const auto &[frequency, antennas] : map_.frequencies)
+        {
+            for (std::size_t i = 0; i < antennas.size(); ++i)
+            {
+                for (std::size_t j = i + 1; j < antennas.size(); ++j)
+                {
+                    std::int64_t dx = antennas[j].x - antennas[i].x;
+                    std::int64_t dy = antennas[j].y - antennas[i].y;
+                    const std::int64_t divisor = std::gcd(dx, dy);
+                    dx /= divisor;
+                    dy /= divisor;
+                    if (dx < 0 || (dx == 0 && dy < 0))
+                    {
+                        dx = -dx;
+                        dy = -dy;
+                    }
+
+                    const WideInt offset = WideInt{dy} * antennas[i].x - WideInt{dx} * antennas[i].y;
+                    lines_.push_back({antennas[i].x, antennas[i].y, dx, dy, offset});
+                }
+            }
+        }
+
+        // Collinear pairs, also across frequencies, span the same line.
+        std::ranges::sort(lines_, {}, &Line::Key);
+        const auto duplicates = std::ranges::unique(lines_, {}, &Line::Key);
+        lines_.erase(duplicates.begin(), duplicates.end());
+    }
+
+    static std::int64_t FloorDiv(std::int64_t a, std::int64_t b)
+    {
+        const std::int64_t q = a / b;
+        return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+    }
+
+    static std::int64_t CeilDiv(std::int64_t a, std::int64_t b)
+    {
+        return -FloorDiv(-a, b);
+    }
+
+    // Restricts t so that 0 <= origin + t * step < limit.
+    static void ClampAxis(std::int64_t origin, std::int64_t step, std::int64_t limit,
+                          std::int64_t &t_min, std::int64_t &t_max)
+    {
+        if (step > 0)
+        {
+            t_min = std::max(t_min, CeilDiv(-origin, step));
+            t_max = std::min(t_max, FloorDiv(limit - 1 - origin, step));
+        }
+        else if (step < 0)
+        {
+            t_min = std::max(t_min, CeilDiv(limit - 1 - origin, step));
+            t_max = std::min(t_max, FloorDiv(-origin, step));
+        }
+    }
+
+    [[nodiscard]] std::uint64_t LatticePointsInside(const Line &line) const
+    {
+        std::int64_t t_min = INT64_MIN;
+        std::int64_t t_max = INT64_MAX;
+        ClampAxis(line.x0, line.dx, map_.width, t_min, t_max);
+        ClampAxis(line.y0, line.dy, map_.height, t_min, t_max);
+        return t_max >= t_min ? static_cast<std::uint64_t>(t_max - t_min + 1) : 0;
+    }
+
+    // Lattice point inside the map shared by two distinct lines, if any.
+    // Wide is int64_t when every product of two coordinates or steps fits,
+    // which holds for maps up to kNarrowExtent, and WideInt otherwise.
+    template <typename Wide>
+    [[nodiscard]] bool Intersect(const Line &a, const Line &b, std::int64_t &x, std::int64_t &y) const
+    {
+        const Wide denominator = Wide{a.dx} * b.dy - Wide{a.dy} * b.dx;
+        if (denominator == 0)
+        {
+            return false;
+        }
+
+        // a.origin + t * a.step lies on b iff t = cross(b.origin - a.origin, b.step) / cross(a.step, b.step).
+        const Wide numerator = Wide{b.x0 - a.x0} * b.dy - Wide{b.y0 - a.y0} * b.dx;
+        if (numerator % denominator != 0)
+        {
+            return false;
+        }
+
+        // Steps are primitive, so a fractional t means the crossing is not
+        // a lattice point; an integral one is a lattice point of both lines.
+        // |t| < 2^32 for any crossing inside the map, so anything larger is
+        // rejected before it could overflow.
+        const Wide t = numerator / denominator;
+        if (t > (Wide{1} << 34) || t < -(Wide{1} << 34))
+        {
+            return false;
+        }
+        const Wide wide_x = a.x0 + t * a.dx;
+        const Wide wide_y = a.y0 + t * a.dy;
+        if (wide_x < 0 || wide_x >= map_.width || wide_y < 0 || wide_y >= map_.height)
+        {
+            return false;
+        }
+        x = static_cast<std::int64_t>(wide_x);
+        y = static_cast<std::int64_t>(wide_y);
+        return true;
+    }
+};
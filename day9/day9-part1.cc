@@ -8,82 +8,75 @@
  * @date 09.12.2024
  */
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
 
+#include "disk_checksum.h"
+
 int main()
 {
     std::ifstream in("input.txt");
     std::string line;
     std::getline(in, line);
 
-    std::vector<int> disk;
+    // Even entries are file lengths, odd entries the gaps after them.
+    std::vector<long long> spans;
+    spans.reserve(line.size());
+    for (char c : line)
     {
-        int file_id = 0;
-        bool file_mode = true;
-        for (char c : line)
-        {
-            int length = c - '0';
-            if (file_mode)
-            {
-                for (int i = 0; i < length; ++i)
-                {
-                    disk.push_back(file_id);
-                }
-                file_id++;
-            }
-            else
-            {
-                for (int i = 0; i < length; ++i)
-                {
-                    disk.push_back(-1);
-                }
-            }
-            file_mode = !file_mode;
-        }
+        if (c >= '0' && c <= '9')
+            spans.push_back(c - '0');
     }
 
-    auto leftmost_free = [&]()
+    if (spans.empty())
     {
-        for (int i = 0; i < (int)disk.size(); ++i)
-        {
-            if (disk[i] == -1)
-                return i;
-        }
-        return -1;
-    };
+        std::cout << 0 << "\n";
+        return 0;
+    }
+
+    // Two pointers that only ever move towards each other: `left` walks the
+    // map in order, `right` is the last file not yet fully moved and
+    // `right_remaining` its blocks still at the end of the disk. Each gap is
+    // filled with whole runs taken from the right, and the checksum is
+    // accumulated as the compacted layout is produced.
+    std::size_t left = 0;
+    std::size_t right = (spans.size() - 1) & ~std::size_t{1};
+    long long right_remaining = spans[right];
+    long long position = 0;
+    DiskChecksum checksum = 0;
 
-    auto rightmost_file = [&]()
+    while (left <= right)
     {
-        for (int i = (int)disk.size() - 1; i >= 0; --i)
+        if (left % 2 == 0)
         {
-            if (disk[i] != -1)
-                return i;
+            long long length = left == right ? right_remaining : spans[left];
+            checksum += SpanChecksum(left / 2, position, length);
+            position += length;
         }
-        return -1;
-    };
-
-    while (true)
-    {
-        int lf = leftmost_free();
-        if (lf == -1)
-            break;
-        int rf = rightmost_file();
-        if (rf == -1 || rf < lf)
-            break;
-        int f = disk[rf];
-        disk[rf] = -1;
-        disk[lf] = f;
-    }
-
-    long long checksum = 0;
-    for (int i = 0; i < (int)disk.size(); ++i)
-    {
-        if (disk[i] != -1)
-            checksum += (long long)i * disk[i];
+        else
+        {
+            long long free_length = spans[left];
+            while (free_length > 0 && right > left)
+            {
+                long long moved = std::min(free_length, right_remaining);
+                checksum += SpanChecksum(right / 2, position, moved);
+                position += moved;
+                free_length -= moved;
+                right_remaining -= moved;
+                if (right_remaining == 0)
+                {
+                    if (right < 2)
+                        break;
+                    right -= 2;
+                    right_remaining = spans[right];
+                }
+            }
+        }
+        ++left;
     }
 
-    std::cout << checksum << "\n";
+    std::cout << ToDecimal(checksum) << "\n";
 }
@@ -9,145 +9,344 @@
  */
 
 #include <algorithm>
-#include <array>
-#include <cassert>
-#include <charconv>
+#include <bit>
+#include <cctype>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
-#include <numeric>
+#include <istream>
 #include <optional>
-#include <ranges>
+#include <stdexcept>
 #include <string>
 #include <string_view>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "disk_checksum.h"
+
+// Segment tree over the gaps in disk order. Gaps are grouped into buckets
+// of kBucketSize, and each node holds the longest gap among its buckets.
+// The leftmost gap of a given length is found in O(log n) by always
+// descending into the left child when it qualifies, then scanning one
+// bucket.
+class FreeSpanTree
+{
+public:
+    explicit FreeSpanTree(std::vector<uint32_t> gaps) : gaps_(std::move(gaps))
+    {
+        leaf_count_ = std::bit_ceil(std::max<size_t>((gaps_.size() + kBucketSize - 1) / kBucketSize, 1));
+        longest_.assign(2 * leaf_count_, 0);
+        for (size_t bucket = 0; bucket * kBucketSize < gaps_.size(); ++bucket)
+        {
+            longest_[leaf_count_ + bucket] = BucketLongest(bucket);
+        }
+        for (size_t node = leaf_count_ - 1; node > 0; --node)
+        {
+            longest_[node] = std::max(longest_[2 * node], longest_[2 * node + 1]);
+        }
+    }
+
+    // Index of the leftmost gap of at least min_length blocks.
+    [[nodiscard]] std::optional<size_t> FindLeftmost(uint32_t min_length) const
+    {
+        if (longest_[1] < min_length)
+        {
+            return std::nullopt;
+        }
+
+        size_t node = 1;
+        while (node < leaf_count_)
+        {
+            node = longest_[2 * node] >= min_length ? 2 * node : 2 * node + 1;
+        }
+
+        size_t gap = (node - leaf_count_) * kBucketSize;
+        while (gaps_[gap] < min_length)
+        {
+            ++gap;
+        }
+        return gap;
+    }
+
+    [[nodiscard]] uint32_t Length(size_t gap) const
+    {
+        return gaps_[gap];
+    }
+
+    // Fills the first length blocks of a gap with a file.
+    void Consume(size_t gap, uint32_t length)
+    {
+        gaps_[gap] -= length;
+
+        const size_t bucket = gap / kBucketSize;
+        size_t node = leaf_count_ + bucket;
+        longest_[node] = BucketLongest(bucket);
+        for (node /= 2; node > 0; node /= 2)
+        {
+            longest_[node] = std::max(longest_[2 * node], longest_[2 * node + 1]);
+        }
+    }
+
+private:
+    static constexpr size_t kBucketSize = 8;
+
+    std::vector<uint32_t> gaps_;
+    size_t leaf_count_ = 1;
+    std::vector<uint32_t> longest_;
+
+    [[nodiscard]] uint32_t BucketLongest(size_t bucket) const
+    {
+        const auto first = gaps_.begin() + static_cast<std::ptrdiff_t>(bucket * kBucketSize);
+        const auto last = gaps_.begin() + static_cast<std::ptrdiff_t>(std::min((bucket + 1) * kBucketSize, gaps_.size()));
+        return *std::max_element(first, last);
+    }
+};
+
 class DiskFragmenter
 {
 public:
-    explicit DiskFragmenter(std::string_view disk_map) { ParseDiskMap(disk_map); }
+    explicit DiskFragmenter(std::istream &disk_map) : free_spans_(ParseDiskMap(disk_map)) {}
 
     void Compact()
     {
-        for (int file_id = static_cast<int>(file_lengths_.size()) - 1; file_id >= 0; --file_id)
+        for (size_t file_id = file_lengths_.size(); file_id-- > 0;)
         {
             MoveFile(file_id);
         }
     }
 
-    [[nodiscard]] int64_t ComputeChecksum() const
+    // Kept up to date as files move, so it never visits individual blocks.
+    [[nodiscard]] DiskChecksum ComputeChecksum() const
     {
-        int64_t checksum = 0;
-        for (size_t pos = 0; pos < blocks_.size(); ++pos)
-        {
-            int file_id = blocks_[pos];
-            if (file_id != kFreeBlock)
-            {
-                checksum += static_cast<int64_t>(pos) * file_id;
-            }
-        }
-        return checksum;
+        return checksum_;
     }
 
 private:
-    static constexpr int kFreeBlock = -1;
+    static constexpr size_t kChunkSize = size_t{1} << 20;
+    static constexpr size_t kFilesPerBlock = 64;
+    static constexpr uint32_t kFarOffset = UINT32_MAX;
 
-    void ParseDiskMap(std::string_view disk_map)
+    // Records the files and returns the gaps: gaps[i] is the free space
+    // right before file i + 1, so it ends at FileStart(i + 1). A gap
+    // followed by an empty file merges into the next one, which ends where
+    // it does. The gap after the last file can never be used and stays 0.
+    //
+    // The map is read in fixed-size chunks up to the first newline, so only
+    // the parsed spans are ever resident. The puzzle format is one digit per
+    // length; a map whose first chunk contains whitespace or commas lists
+    // its lengths as decimal numbers instead, e.g. "12 0 7,130". Numbers
+    // may straddle chunk boundaries.
+    std::vector<uint32_t> ParseDiskMap(std::istream &disk_map)
     {
-        blocks_.clear();
+        block_starts_.clear();
+        file_offsets_.clear();
+        far_starts_.clear();
         file_lengths_.clear();
+        checksum_ = 0;
 
-        size_t idx = 0;
-        int file_id = 0;
-        auto disk_map_size = disk_map.size();
+        std::vector<uint32_t> gaps;
+        int64_t position = 0;
+        bool is_file = true;
 
-        auto CharToInt = [](char ch) -> int
+        // A seekable digit map has one file per two bytes, so the vectors
+        // can be sized up front instead of doubling (and briefly holding
+        // both copies) while parsing.
+        size_t expected_files = 0;
+        if (const std::streampos begin = disk_map.tellg(); begin != std::streampos(-1))
         {
-            assert(std::isdigit(ch));
-            return ch - '0';
+            disk_map.seekg(0, std::ios::end);
+            const std::streampos end = disk_map.tellg();
+            disk_map.seekg(begin);
+            if (disk_map && end != std::streampos(-1))
+            {
+                expected_files = static_cast<size_t>(end - begin) / 2 + 1;
+            }
+        }
+        disk_map.clear();
+
+        auto AddLength = [&](int64_t length)
+        {
+            if (length > UINT32_MAX)
+            {
+                throw std::out_of_range("Disk map length out of range");
+            }
+            if (is_file)
+            {
+                checksum_ += SpanChecksum(file_lengths_.size(), position, length);
+                if (file_offsets_.size() % kFilesPerBlock == 0)
+                {
+                    block_starts_.push_back(position);
+                }
+                const int64_t offset = position - block_starts_.back();
+                if (offset >= kFarOffset)
+                {
+                    far_starts_.emplace_back(file_offsets_.size(), position);
+                    file_offsets_.push_back(kFarOffset);
+                }
+                else
+                {
+                    file_offsets_.push_back(static_cast<uint32_t>(offset));
+                }
+                file_lengths_.push_back(static_cast<uint32_t>(length));
+                const uint32_t carried = length == 0 && !gaps.empty() ? std::exchange(gaps.back(), 0) : 0;
+                gaps.push_back(carried);
+            }
+            else if (__builtin_add_overflow(gaps.back(), static_cast<uint32_t>(length), &gaps.back()))
+            {
+                throw std::out_of_range("Free span length out of range");
+            }
+            position += length;
+            is_file = !is_file;
         };
 
-        while (idx < disk_map_size)
+        std::vector<char> chunk(kChunkSize);
+        std::optional<bool> multi_digit;
+        int64_t number = 0;
+        bool in_number = false;
+        bool end_of_line = false;
+
+        while (!end_of_line)
         {
-            int file_length = CharToInt(disk_map[idx]);
-            file_lengths_.push_back(file_length);
-            idx++;
-            blocks_.insert(blocks_.end(), file_length, file_id);
-            file_start_positions_[file_id] = static_cast<int>(blocks_.size()) - file_length;
-            file_id++;
-            if (idx >= disk_map_size)
+            disk_map.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+            std::string_view view(chunk.data(), static_cast<size_t>(disk_map.gcount()));
+            if (view.empty())
+            {
                 break;
+            }
+            if (const size_t newline = view.find('\n'); newline != std::string_view::npos)
+            {
+                view = view.substr(0, newline);
+                end_of_line = true;
+            }
+            if (!multi_digit)
+            {
+                multi_digit = view.find_first_of(" ,\t") != std::string_view::npos;
+                if (!*multi_digit)
+                {
+                    block_starts_.reserve(expected_files / kFilesPerBlock + 1);
+                    file_offsets_.reserve(expected_files);
+                    file_lengths_.reserve(expected_files);
+                    gaps.reserve(expected_files);
+                }
+            }
 
-            int free_length = CharToInt(disk_map[idx]);
-            idx++;
-            blocks_.insert(blocks_.end(), free_length, kFreeBlock);
+            for (char ch : view)
+            {
+                if (!std::isdigit(static_cast<unsigned char>(ch)))
+                {
+                    if (in_number)
+                    {
+                        AddLength(number);
+                        number = 0;
+                        in_number = false;
+                    }
+                }
+                else if (!*multi_digit)
+                {
+                    AddLength(ch - '0');
+                }
+                else if (__builtin_mul_overflow(number, 10, &number) ||
+                         __builtin_add_overflow(number, ch - '0', &number))
+                {
+                    throw std::out_of_range("Disk map length out of range");
+                }
+                else
+                {
+                    in_number = true;
+                }
+            }
         }
+        if (in_number)
+        {
+            AddLength(number);
+        }
+        if (!gaps.empty())
+        {
+            gaps.back() = 0;
+        }
+
+        // Only give back real slack; shrinking copies the whole vector.
+        auto TrimCapacity = [](auto &values)
+        {
+            if (values.capacity() - values.size() > values.size() / 16)
+            {
+                values.shrink_to_fit();
+            }
+        };
+        TrimCapacity(block_starts_);
+        TrimCapacity(file_offsets_);
+        TrimCapacity(file_lengths_);
+        TrimCapacity(gaps);
+        return gaps;
     }
 
-    void MoveFile(int file_id)
+    // The space a file leaves behind is never handed out again: every file
+    // still to move lies left of it. Files keep their original start,
+    // which is what the gaps are measured against; only the checksum learns
+    // where a file went.
+    void MoveFile(size_t file_id)
     {
-        int file_length = file_lengths_[file_id];
-        int current_pos = file_start_positions_[file_id];
+        const uint32_t file_length = file_lengths_[file_id];
+        if (file_length == 0)
+        {
+            return;
+        }
 
-        auto free_span = FindLeftmostFreeSpan(file_length, current_pos);
-        if (free_span)
+        auto gap = free_spans_.FindLeftmost(file_length);
+        if (!gap)
         {
-            int dest_pos = free_span.value();
-            std::copy_n(blocks_.begin() + current_pos, file_length, blocks_.begin() + dest_pos);
-            std::fill_n(blocks_.begin() + current_pos, file_length, kFreeBlock);
-            file_start_positions_[file_id] = dest_pos;
+            return;
         }
+        const int64_t file_start = FileStart(file_id);
+        const int64_t gap_start = FileStart(*gap + 1) - free_spans_.Length(*gap);
+        if (gap_start >= file_start)
+        {
+            return;
+        }
+
+        checksum_ -= SpanChecksum(file_id, file_start, file_length);
+        checksum_ += SpanChecksum(file_id, gap_start, file_length);
+        free_spans_.Consume(*gap, file_length);
     }
 
-    [[nodiscard]] std::optional<int> FindLeftmostFreeSpan(int file_length, int current_pos) const
+    [[nodiscard]] int64_t FileStart(size_t file_id) const
     {
-        int left = 0;
-        while (left < current_pos)
+        if (file_offsets_[file_id] == kFarOffset)
         {
-            while (left < current_pos && blocks_[left] != kFreeBlock)
-            {
-                ++left;
-            }
-            int right = left;
-            while (right < current_pos && blocks_[right] == kFreeBlock)
-            {
-                ++right;
-            }
-            int span_length = right - left;
-            if (span_length >= file_length)
-            {
-                return left;
-            }
-            left = right;
+            return std::ranges::lower_bound(far_starts_, file_id, {}, &std::pair<size_t, int64_t>::first)->second;
         }
-        return std::nullopt;
+        return block_starts_[file_id / kFilesPerBlock] + file_offsets_[file_id];
     }
 
-    std::vector<int> blocks_;
-    std::vector<int> file_lengths_;
-    std::unordered_map<int, int> file_start_positions_;
+    // Starts never change, so they are stored as one 64-bit start per
+    // block of kFilesPerBlock files plus a 32-bit offset per file. With
+    // the length, one gap per file and the tree over the gaps this is
+    // about 13 bytes per file. Offsets that do not fit into 32 bits, which
+    // only long multi-digit lengths produce, are marked kFarOffset and
+    // kept in far_starts_, sorted by file id.
+    std::vector<int64_t> block_starts_;
+    std::vector<uint32_t> file_offsets_;
+    std::vector<std::pair<size_t, int64_t>> far_starts_;
+    std::vector<uint32_t> file_lengths_;
+    DiskChecksum checksum_ = 0;
+    FreeSpanTree free_spans_;
 };
 
 int main()
 {
-    std::ifstream input_file("input.txt");
+    std::ifstream input_file("input.txt", std::ios::binary);
     if (!input_file)
     {
         std::cerr << "Error opening input file 'input.txt'" << std::endl;
         return 1;
     }
 
-    std::string disk_map_input;
-    std::getline(input_file, disk_map_input);
+    DiskFragmenter fragmenter(input_file);
     input_file.close();
 
-    DiskFragmenter fragmenter(disk_map_input);
-
     fragmenter.Compact();
 
-    int64_t checksum = fragmenter.ComputeChecksum();
-    std::cout << checksum << std::endl;
+    std::cout << ToDecimal(fragmenter.ComputeChecksum()) << std::endl;
 
     return 0;
-}
\ No newline at end of file
+}
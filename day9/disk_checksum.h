@@ -0,0 +1,44 @@
+/**
+ * @file disk_checksum.h
+ * @brief Filesystem checksum shared by both parts of Advent of Code 2024 Day 9
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * @author Volker Schwaberow <volker@schwaberow.de>
+ * @date 09.12.2024
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+// The checksum of a disk with b blocks is below b^3, which overflows 64
+// bits from about 2^21 blocks on. 128 bits hold it exactly up to 2^42
+// blocks, far more than any map that fits into memory describes.
+__extension__ typedef unsigned __int128 DiskChecksum;
+
+// file_id * (start + ... + start + length - 1).
+inline DiskChecksum SpanChecksum(uint64_t file_id, uint64_t start, uint64_t length)
+{
+    if (length == 0)
+    {
+        return 0;
+    }
+    const DiskChecksum block_sum = DiskChecksum{length} * start + DiskChecksum{length} * (length - 1) / 2;
+    return block_sum * file_id;
+}
+
+// Decimal digits of a checksum; iostreams have no 128-bit overload.
+inline std::string ToDecimal(DiskChecksum value)
+{
+    std::string digits;
+    do
+    {
+        digits.push_back(static_cast<char>('0' + static_cast<int>(value % 10)));
+        value /= 10;
+    } while (value != 0);
+    std::reverse(digits.begin(), digits.end());
+    return digits;
+}